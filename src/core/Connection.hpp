@@ -1,7 +1,9 @@
 #pragma once
 #include "../http/HttpServer.hpp"
-#include "../http/FileService.hpp"
+#include "../http/Router.hpp"
 #include "../utils/PerformanceMonitor.hpp"
+#include "../utils/AccessLog.hpp"
+#include "RequestArena.hpp"
 #include "Task.hpp"
 #include "ConnectionManager.hpp"
 #include "Config.hpp"
@@ -13,9 +15,15 @@
 class Connection {
 public:
     int fd;
+    RequestArena arena;  // 请求和响应状态的内存池，每个请求结束后整体重置，必须先于request和response构造
     HttpServer::HttpRequest request;
     HttpServer::HttpResponse response;
+    PerformanceMonitor::RequestInfo requestInfo;  // 当前请求的计时信息
+    RequestTimeline timeline;  // 当前请求各阶段的时间戳，只在启用性能监控或访问日志时记录
+    ConnectionStats stats;     // 连接统计，只在启用时挂到请求和响应上
+    sockaddr_storage peer{};   // 客户端地址，只在启用访问日志或连接统计时获取
     Task task;  // 协程任务
+    bool closed = false;  // fd已关闭，等待在本轮事件处理结束后从连接管理器中移除
     
     void startHandleConnection(int epollFd) {
         task = handleConnection(epollFd); // 存储协程任务
@@ -27,11 +35,12 @@ public:
         epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
         // 关闭文件描述符
         ::close(fd);
+        closed = true;
         // 将自身安排为在当前协程完成后删除
         int connectionFd = fd;
         ConnectionManager::getInstance().postTask([connectionFd]() {
             ConnectionManager::getInstance().removeConnection(connectionFd);
-            LOG_INFO(fmt::format("连接已成功移除: {}", connectionFd));
+            LOG_INFO("连接已成功移除: {}", connectionFd);
         });
     }
     
@@ -44,120 +53,85 @@ public:
                 // 重置状态
                 request.reset();
                 response.reset();
+                // 上一个请求的状态已全部释放，内存池回到起点
+                arena.reset();
+                timeline.reset();
+                stats.setState(ConnectionStats::Idle);
                 
                 try {
                     co_await HttpServer::HttpRequestAwaiter(request, fd, epollFd);
                 } catch (const std::exception& e) {
-                    LOG_ERROR(fmt::format("请求解析错误: {}", e.what()));
+                    LOG_ERROR("请求解析错误: {}", e.what());
                     break;  // 出错时退出循环
                 }
                 
                 // 获取HTTP方法
-                std::string method = request.method();
-                std::string path = request.path();
+                std::string_view method = request.method();
+                std::string_view path = request.path();
                 
-                LOG_INFO(fmt::format("处理请求: {} {}", method, path));
+                LOG_INFO("处理请求: {} {}", method, path);
+                stats.setState(ConnectionStats::Handling);
                 
                 // 设置Connection头
                 bool keepAlive = (request.getHeader("Connection") != "close");
-                if (keepAlive) {
-                    response.setHeader("Connection", "keep-alive");
-                    response.setHeader("Keep-Alive", "timeout=5, max=100");
-                } else {
-                    response.setHeader("Connection", "close");
-                }
-                
-                // 生成唯一请求ID用于追踪
-                std::string requestId = fmt::format("{:x}", 
-                    reinterpret_cast<uintptr_t>(this) ^ 
-                    std::hash<std::string>{}(path) ^ 
-                    std::chrono::high_resolution_clock::now().time_since_epoch().count());
+                response.setKeepAlive(keepAlive);
                 
-                // 开始性能监控
-                PerformanceMonitor::getInstance().startRequest(requestId, method, path);
+                // 开始性能监控，开始时间保存在连接上
+                requestInfo = PerformanceMonitor::getInstance().startRequest(method, path, this);
                 
-                // 根据HTTP方法处理请求
-                std::string statusCode = "200"; // 默认状态码
+                // 按路由分派到处理函数，没有匹配的路由时返回404，方法未注册时返回501
+                RequestTimeline* activeTimeline = timelineEnabled() ? &timeline : nullptr;
+                RequestContext ctx{request, response, fd, epollFd, activeTimeline};
+                auto match = Router::getInstance().match(method, path, ctx.params);
+                requestInfo.route = match.route;
+                ctx.route = match.route;
+                stats.route = match.route;
+                ctx.noteResumed();
+                bool sendFailed = false;
                 
                 try {
-                    // 检查特殊请求路径
-                    if (path == "/server-status") {
-                        // 显示服务器状态
-                        response.setStatus("200", "OK");
-                        response.setContentType("text/plain; charset=UTF-8");
-                        response.setBody(PerformanceMonitor::getInstance().getStatsSummary());
-                    } else if (path == "/server-info") {
-                        // 服务器信息
-                        std::string info = "C++20 HTTP服务器\n";
-                        info += "版本: 1.0.0\n";
-                        info += fmt::format("配置文件: {}\n", Config::getInstance().getString("config_file", "server.conf"));
-                        info += fmt::format("根目录: {}\n", Config::getInstance().getString("root_dir", "./www"));
-                        info += fmt::format("监听地址: {}:{}\n", Config::getInstance().getString("host", "127.0.0.1"), Config::getInstance().getString("port", "8080"));
-                        info += fmt::format("允许目录列表: {}\n", Config::getInstance().getBool("allow_directory_listing", false) ? "是" : "否");
-                        
-                        response.setStatus("200", "OK");
-                        response.setContentType("text/plain; charset=UTF-8");
-                        response.setBody(info);
-                    } else if (method == "GET" || method == "HEAD") {
-                        // 静态文件服务
-                        auto fileResponse = FileService::getInstance().getFileContent(path);
-                        statusCode = fileResponse.statusCode; // 更新状态码
-                        response.setStatus(statusCode, "");
-                        
-                        if (statusCode == "200") {
-                            // 使用文件服务提供的MIME类型
-                            response.setContentType(fileResponse.mimeType);
-                            LOG_DEBUG(fmt::format("文件 {} 的MIME类型: {}", path, fileResponse.mimeType));
-                            
-                            // 如果是HEAD请求，不返回响应体
-                            if (method == "GET") {
-                                response.setBody(fileResponse.content);
-                            } else {
-                                // 对于HEAD请求，设置Content-Length但不发送正文
-                                response.setHeader("Content-Length", std::to_string(fileResponse.content.length()));
-                            }
-                        } else if (statusCode == "404") {
-                            response.setContentType("text/html; charset=UTF-8");
-                            response.setBody("<html><body><h1>404 Not Found</h1><p>您请求的资源在此服务器上未找到。</p></body></html>");
-                        } else if (statusCode == "403") {
-                            response.setContentType("text/html; charset=UTF-8");
-                            response.setBody("<html><body><h1>403 Forbidden</h1><p>您没有权限访问此资源。</p></body></html>");
-                        } else {
-                            response.setContentType("text/html; charset=UTF-8");
-                            response.setBody("<html><body><h1>500 Internal Server Error</h1><p>服务器遇到意外条件，无法完成请求。</p></body></html>");
+                    if (match.handler != nullptr) {
+                        if (activeTimeline) {
+                            activeTimeline->beginHandler();
                         }
-                    } else if (method == "POST") {
-                        // 简单的POST请求处理
-                        response.setStatus("200", "OK");
-                        statusCode = "200";
-                        response.setContentType("text/plain; charset=UTF-8");
-                        response.setBody("收到POST请求，请求体内容: " + request.body());
+                        co_await match.handler(ctx);
                     } else {
-                        // 不支持的方法
-                        response.setStatus("501", "Not Implemented");
-                        statusCode = "501";
-                        response.setContentType("text/html; charset=UTF-8");
-                        response.setBody("<html><body><h1>501 未实现</h1><p>服务器不支持此请求方法。</p></body></html>");
+                        ctx.setErrorPage(match.pathMatched ? 501 : 404, method == "HEAD");
                     }
                 } catch (const std::exception& e) {
-                    LOG_ERROR(fmt::format("处理请求时发生异常: {}", e.what()));
-                    response.setStatus("500", "Internal Server Error");
-                    statusCode = "500";
-                    response.setContentType("text/html; charset=UTF-8");
-                    response.setBody("<html><body><h1>500 Internal Server Error</h1><p>服务器遇到意外错误。</p></body></html>");
+                    LOG_ERROR("处理请求时发生异常: {}", e.what());
+                    // 响应已开始发送时无法再改为错误页面，只能关闭连接
+                    if (ctx.responseStarted) {
+                        sendFailed = true;
+                    } else {
+                        ctx.setErrorPage(500);
+                    }
+                }
+                if (activeTimeline) {
+                    activeTimeline->endHandler();
                 }
                 
-                // 发送响应
+                // 发送响应（处理函数已自行流式发送的除外），HEAD请求只发送头部
                 try {
-                    co_await HttpServer::HttpResponseAwaiter(response, fd, epollFd);
-                    
-                    // 更新性能监控
-                    PerformanceMonitor::getInstance().endRequest(requestId, std::stoi(statusCode));
+                    if (!sendFailed && !ctx.responseStarted) {
+                        if (method == "HEAD") {
+                            response.omitBody();
+                        }
+                        co_await ctx.send();
+                    }
                 } catch (const std::exception& e) {
-                    LOG_ERROR(fmt::format("响应发送错误: {}", e.what()));
-                    
-                    // 更新性能监控（失败状态）
-                    PerformanceMonitor::getInstance().endRequest(requestId, 500);
+                    LOG_ERROR("响应发送错误: {}", e.what());
+                    sendFailed = true;
+                }
+                
+                // 更新性能监控，发送失败按500计
+                int status = sendFailed ? 500 : response.getStatus();
+                PerformanceMonitor::getInstance().endRequest(requestInfo, status, activeTimeline);
+                ++stats.requests;
+                if (AccessLog::getInstance().isEnabled()) {
+                    AccessLog::getInstance().log(method, path, status, keepAlive, peer, timeline);
+                }
+                if (sendFailed) {
                     break;  // 出错时退出循环
                 }
                 
@@ -167,7 +141,7 @@ public:
                 }
             }
         } catch (const std::exception& e) {
-            LOG_ERROR(fmt::format("连接处理错误: {}", e.what()));
+            LOG_ERROR("连接处理错误: {}", e.what());
         }
         
         // 记录连接关闭
@@ -178,8 +152,29 @@ public:
         co_return;
     }
     
-    explicit Connection(int fd) : fd(fd), task(nullptr) {
-        LOG_DEBUG(fmt::format("新连接建立: {}", fd));
+    explicit Connection(int fd)
+        : fd(fd), arena(std::max(Config::getInstance().getInt("request_arena_size", 16), 1) * 1024),
+          request(arena.get()), response(arena.get()), task(nullptr) {
+        if (timelineEnabled()) {
+            request.setTimeline(&timeline);
+            response.setTimeline(&timeline);
+        }
+        if (ConnectionManager::getInstance().isStatsEnabled()) {
+            request.setStats(&stats);
+            response.setStats(&stats);
+        }
+        if (AccessLog::getInstance().isEnabled() || ConnectionManager::getInstance().isStatsEnabled()) {
+            socklen_t peerLength = sizeof(peer);
+            if (getpeername(fd, reinterpret_cast<sockaddr*>(&peer), &peerLength) != 0) {
+                peer.ss_family = AF_UNSPEC;
+            }
+        }
+        LOG_DEBUG("新连接建立: {}", fd);
+    }
+    
+    // 性能监控和访问日志都需要请求的时间线
+    static bool timelineEnabled() {
+        return PerformanceMonitor::getInstance().isEnabled() || AccessLog::getInstance().isEnabled();
     }
     
     ~Connection() {
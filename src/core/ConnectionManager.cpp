@@ -20,4 +20,20 @@ void ConnectionManager::removeConnection(int fd) {
 
 bool ConnectionManager::hasConnection(int fd) const {
     return connections.find(fd) != connections.end();
+}
+
+std::vector<ConnectionTable::Entry> ConnectionManager::collectStats() const {
+    std::vector<ConnectionTable::Entry> entries;
+    entries.reserve(connections.size());
+    for (const auto& [fd, conn] : connections) {
+        // 已关闭但尚未移除的连接不再占用资源，不列出
+        if (conn->closed) {
+            continue;
+        }
+        ConnectionTable::Entry entry{fd, {}, conn->stats};
+        std::memcpy(&entry.peer.addr, &conn->peer, sizeof(conn->peer));
+        entry.peer.addrlen = conn->peer.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+        entries.push_back(entry);
+    }
+    return entries;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include "../utils/ConnectionStats.hpp"
 
 // 前向声明 Connection 类
 class Connection;
@@ -47,6 +48,18 @@ public:
 
     bool hasConnection(int fd) const;
     
+    // 连接统计开关，在接受第一个连接之前设置
+    void setStatsEnabled(bool enabled) {
+        statsEnabled = enabled;
+    }
+    
+    bool isStatsEnabled() const {
+        return statsEnabled;
+    }
+    
+    // 全部未关闭连接的统计快照，供/server-status/connections排序输出
+    std::vector<ConnectionTable::Entry> collectStats() const;
+    
     size_t count() const {
         return connections.size();
     }
@@ -66,4 +79,5 @@ public:
 
 private:
     std::vector<std::function<void()>> pendingTasks;
+    bool statsEnabled = false;
 };
\ No newline at end of file
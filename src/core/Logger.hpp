@@ -3,8 +3,19 @@
 #include <fstream>
 #include <mutex>
 #include <chrono>
-#include <sstream>
-#include <iomanip>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <string_view>
+#include <ctime>
 #include <fmt/format.h>
 
 enum class LogLevel {
@@ -15,8 +26,17 @@ enum class LogLevel {
     FATAL
 };
 
+// 日志：默认在调用线程中同步写入；启用异步模式后，调用线程把消息直接格式化进本线程环形缓冲区中的
+// 定长记录（无锁、不分配内存，超长的消息被截断），由后台线程定期取出、按时间排序、加上时间戳和
+// 级别等前后缀，并以一次大的写入输出到文件和控制台
 class Logger {
 public:
+    // 异步模式下缓冲区满时的处理方式：丢弃并计数，或等待后台线程腾出空间
+    enum class OverflowPolicy {
+        Drop,
+        Block
+    };
+
     static Logger& getInstance() {
         static Logger instance;
         return instance;
@@ -25,17 +45,17 @@ public:
     // 初始化日志系统
     bool init(const std::string& logFilePath, LogLevel minLevel = LogLevel::INFO, bool enableLogging = true, bool enableConsoleOutput = true) {
         std::lock_guard<std::mutex> lock(mutex);
-        
+
         // 设置是否启用日志和控制台输出
         this->enableLogging = enableLogging;
         this->enableConsoleOutput = enableConsoleOutput;
-        
+
         // 如果不启用日志，则直接返回
         if (!enableLogging) {
             isInitialized = false;
             return true;
         }
-        
+
         logFile.open(logFilePath, std::ios::app);
         if (!logFile.is_open()) {
             if (enableConsoleOutput) {
@@ -49,28 +69,132 @@ public:
         return true;
     }
 
-    // 写入日志
-    void log(LogLevel level, const std::string& message, const char* file = "", int line = 0) {
-        if (!isInitialized || level < minLogLevel || !enableLogging) {
+    // 异步模式下每条记录的定长大小，消息部分超出时截断
+    static constexpr size_t RECORD_SIZE = 256;
+
+    // 启用异步模式：bufferSize为每个线程环形缓冲区的记录数（向上取整为2的幂），
+    // flushInterval为后台线程写出的最长间隔；缓冲区过半或出现ERROR及以上级别时提前写出
+    void startAsync(size_t bufferSize, std::chrono::milliseconds flushInterval, OverflowPolicy policy) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isInitialized || writerThread.joinable()) {
             return;
         }
+        ringCapacity = std::bit_ceil(std::max<size_t>(bufferSize, 16));
+        this->flushInterval = std::max(flushInterval, std::chrono::milliseconds(1));
+        overflowPolicy = policy;
+        stopping = false;
+        writerThread = std::thread([this] { runWriter(); });
+        async.store(true, std::memory_order_release);
+    }
+
+    bool isAsync() const {
+        return async.load(std::memory_order_relaxed);
+    }
+
+    // 异步模式下因缓冲区满而丢弃的记录数
+    uint64_t getDroppedCount() const {
+        uint64_t total = 0;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& ring : rings) {
+            total += ring->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
 
+    // 写入已格式化好的消息
+    void log(LogLevel level, std::string_view message, const char* file = "", int line = 0) {
+        if (!shouldLog(level)) {
+            return;
+        }
+        if (tryEnqueue(level, file, line, [message](Record& record) { record.setMessage(message); })) {
+            return;
+        }
+        writeSync(level, message, file, line);
+    }
+
+    // 当前是否输出该级别的日志；日志宏先检查这里，不输出时不格式化消息
+    bool shouldLog(LogLevel level) const {
+        return isInitialized && enableLogging && level >= minLogLevel;
+    }
+
+    // 按格式字符串格式化后写入，格式字符串在编译期检查
+    // 异步模式下直接格式化进环形缓冲区的记录，同步模式下格式化到栈上的缓冲区
+    template <typename... Args>
+    void logFormat(LogLevel level, const char* file, int line, fmt::format_string<Args...> format, Args&&... args) {
+        bool queued = tryEnqueue(level, file, line, [&](Record& record) {
+            // fmt只读取参数、不会移走它们，同步分支中还可以再次使用
+            auto result = fmt::format_to_n(record.text, Record::TEXT_CAPACITY, format, std::forward<Args>(args)...);
+            record.setLength(result.size);
+        });
+        if (!queued) {
+            fmt::memory_buffer buffer;
+            fmt::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+            writeSync(level, std::string_view(buffer.data(), buffer.size()), file, line);
+        }
+    }
+
+    // 关闭日志，异步模式下先写出缓冲区中剩余的记录
+    void close() {
+        stopWriter();
         std::lock_guard<std::mutex> lock(mutex);
-        
-        std::string timestamp = getCurrentTimestamp();
-        std::string levelStr = getLevelString(level);
-        std::string locationInfo = "";
-        
-        if (file && line > 0) {
-            locationInfo = fmt::format(" [{}:{}]", file, line);
+        if (logFile.is_open()) {
+            logFile.close();
         }
+        isInitialized = false;
+    }
+
+    ~Logger() {
+        close();
+    }
+
+private:
+    // 记录中消息之前的字段；file指向__FILE__字面量
+    struct RecordHeader {
+        std::chrono::system_clock::time_point time;
+        const char* file;
+        int line;
+        LogLevel level;
+        uint32_t length;
+        bool truncated;
+    };
+
+    // 一条待写出的日志，定长以便整块放在环形缓冲区中
+    // 消息超出TEXT_CAPACITY时只保留前面的部分，写出时以" ..."标记
+    struct Record : RecordHeader {
+        static constexpr size_t TEXT_CAPACITY = RECORD_SIZE - sizeof(RecordHeader);
+
+        char text[TEXT_CAPACITY];
+
+        // size为完整消息的长度，超过容量时记为截断
+        void setLength(size_t size) {
+            truncated = size > TEXT_CAPACITY;
+            length = static_cast<uint32_t>(std::min(size, TEXT_CAPACITY));
+        }
+
+        void setMessage(std::string_view message) {
+            size_t copied = std::min(message.size(), TEXT_CAPACITY);
+            std::memcpy(text, message.data(), copied);
+            setLength(message.size());
+        }
+
+        std::string_view message() const {
+            return std::string_view(text, length);
+        }
+    };
+
+    static_assert(sizeof(Record) == RECORD_SIZE, "日志记录应为定长");
+
+    // 同步写入：持锁格式化整行后写入文件和控制台
+    void writeSync(LogLevel level, std::string_view message, const char* file, int line) {
+        auto now = std::chrono::system_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string logEntry;
+        appendEntry(logEntry, level, now, message, false, file, line);
 
-        std::string logEntry = fmt::format("{} {} {}{}\n", timestamp, levelStr, message, locationInfo);
-        
         // 写入文件
         logFile << logEntry;
         logFile.flush();
-        
+
         // 根据配置决定是否输出到控制台
         if (enableConsoleOutput) {
             if (level >= LogLevel::WARNING) {
@@ -81,66 +205,223 @@ public:
         }
     }
 
-    void debug(const std::string& message, const char* file = "", int line = 0) {
-        log(LogLevel::DEBUG, message, file, line);
+    // 单生产者（所属线程）单消费者（后台线程）的环形缓冲区
+    // head和tail单调递增，分处不同缓存行；tail以release发布新记录，head以release归还空位
+    struct Ring {
+        explicit Ring(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+        std::vector<Record> slots;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    Logger() : isInitialized(false), minLogLevel(LogLevel::INFO) {}
+
+    // 删除复制和移动构造/赋值
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    Logger(Logger&&) = delete;
+    Logger& operator=(Logger&&) = delete;
+
+    // 当前线程的环形缓冲区，首次使用时登记；线程退出后保留，剩余记录照常写出
+    Ring& localRing() {
+        thread_local Ring* ring = nullptr;
+        if (ring == nullptr) {
+            auto created = std::make_unique<Ring>(ringCapacity);
+            ring = created.get();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            rings.push_back(std::move(created));
+        }
+        return *ring;
+    }
+
+    // 异步模式下把记录放入本线程的缓冲区，fill负责填写消息；未启用异步模式时返回false
+    // producers统计正在放入记录的线程：关闭时先清除async，再等待producers归零，
+    // 之后不会再有记录进入缓冲区，后台线程最后一次取出的就是全部记录
+    template <typename Fill>
+    bool tryEnqueue(LogLevel level, const char* file, int line, Fill&& fill) {
+        producers.fetch_add(1);
+        bool queued = async.load();
+        if (queued) {
+            enqueue(level, file, line, fill);
+        }
+        producers.fetch_sub(1);
+        return queued;
     }
 
-    void info(const std::string& message, const char* file = "", int line = 0) {
-        log(LogLevel::INFO, message, file, line);
+    template <typename Fill>
+    void enqueue(LogLevel level, const char* file, int line, Fill& fill) {
+        Ring& ring = localRing();
+        size_t capacity = ring.slots.size();
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        // 阻塞策略下等待期间后台线程一直在运行（关闭时等所有生产者退出后才停止它）
+        while (tail - ring.head.load(std::memory_order_acquire) == capacity) {
+            if (overflowPolicy == OverflowPolicy::Drop) {
+                ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            wake();
+            std::this_thread::yield();
+        }
+        Record& record = ring.slots[tail & ring.mask];
+        record.time = std::chrono::system_clock::now();
+        record.file = file;
+        record.line = line;
+        record.level = level;
+        fill(record);
+        ring.tail.store(tail + 1, std::memory_order_release);
+        if (level >= LogLevel::ERROR || tail + 1 - ring.head.load(std::memory_order_relaxed) == capacity / 2) {
+            wake();
+        }
     }
 
-    void warning(const std::string& message, const char* file = "", int line = 0) {
-        log(LogLevel::WARNING, message, file, line);
+    void wake() {
+        wakeRequested.store(true, std::memory_order_release);
+        wakeCondition.notify_one();
     }
 
-    void error(const std::string& message, const char* file = "", int line = 0) {
-        log(LogLevel::ERROR, message, file, line);
+    // 后台线程：等待刷新间隔或被唤醒，然后写出所有缓冲区中的记录
+    void runWriter() {
+        std::vector<Record> batch;
+        std::string fileBuffer, outBuffer, errorBuffer;
+        uint64_t reportedDrops = 0;
+        while (true) {
+            bool exiting;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCondition.wait_for(lock, flushInterval, [this] {
+                    return stopping || wakeRequested.load(std::memory_order_acquire);
+                });
+                wakeRequested.store(false, std::memory_order_relaxed);
+                exiting = stopping;
+            }
+
+            drain(batch);
+            uint64_t drops = getDroppedCount();
+            if (drops != reportedDrops) {
+                Record& warning = batch.emplace_back();
+                warning.time = std::chrono::system_clock::now();
+                warning.file = "";
+                warning.line = 0;
+                warning.level = LogLevel::WARNING;
+                warning.setMessage(fmt::format("日志缓冲区已满，丢弃 {} 条日志", drops - reportedDrops));
+                reportedDrops = drops;
+            }
+            if (!batch.empty()) {
+                writeBatch(batch, fileBuffer, outBuffer, errorBuffer);
+                batch.clear();
+            }
+            if (exiting) {
+                break;
+            }
+        }
     }
 
-    void fatal(const std::string& message, const char* file = "", int line = 0) {
-        log(LogLevel::FATAL, message, file, line);
+    // 取出所有缓冲区中的记录，按时间排序（同一线程内的记录已经有序）
+    void drain(std::vector<Record>& batch) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& ring : rings) {
+            size_t head = ring->head.load(std::memory_order_relaxed);
+            size_t tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                batch.push_back(std::move(ring->slots[head & ring->mask]));
+            }
+            ring->head.store(head, std::memory_order_release);
+        }
+        if (rings.size() > 1) {
+            std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+                return a.time < b.time;
+            });
+        }
     }
 
-    // 关闭日志
-    void close() {
+    // 整批格式化后写出：文件一次写入，控制台按级别分到标准输出和标准错误
+    void writeBatch(const std::vector<Record>& batch, std::string& fileBuffer,
+                    std::string& outBuffer, std::string& errorBuffer) {
+        fileBuffer.clear();
+        outBuffer.clear();
+        errorBuffer.clear();
+        for (const auto& record : batch) {
+            size_t start = fileBuffer.size();
+            appendEntry(fileBuffer, record.level, record.time, record.message(), record.truncated, record.file,
+                record.line);
+            if (enableConsoleOutput) {
+                auto& console = record.level >= LogLevel::WARNING ? errorBuffer : outBuffer;
+                console.append(fileBuffer, start, std::string::npos);
+            }
+        }
+
         std::lock_guard<std::mutex> lock(mutex);
         if (logFile.is_open()) {
-            logFile.close();
+            logFile.write(fileBuffer.data(), fileBuffer.size());
+            logFile.flush();
+        }
+        if (!outBuffer.empty()) {
+            fmt::print("{}", outBuffer);
+            std::fflush(stdout);
+        }
+        if (!errorBuffer.empty()) {
+            fmt::print(stderr, "{}", errorBuffer);
         }
-        isInitialized = false;
     }
 
-    ~Logger() {
-        close();
+    // 停止后台线程并写出剩余记录，之后的日志回到同步写入
+    // 先关闭异步模式并等待正在放入记录的线程退出，再让后台线程做最后一次取出，不会漏掉记录
+    void stopWriter() {
+        if (!writerThread.joinable()) {
+            return;
+        }
+        async.store(false);
+        while (producers.load() != 0) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_one();
+        writerThread.join();
     }
 
-private:
-    Logger() : isInitialized(false), minLogLevel(LogLevel::INFO) {}
-    
-    // 删除复制和移动构造/赋值
-    Logger(const Logger&) = delete;
-    Logger& operator=(const Logger&) = delete;
-    Logger(Logger&&) = delete;
-    Logger& operator=(Logger&&) = delete;
+    // 格式化一条日志："时间 级别 消息 [文件:行]"，截断的消息以" ..."结尾
+    static void appendEntry(std::string& out, LogLevel level, std::chrono::system_clock::time_point time,
+                            std::string_view message, bool truncated, const char* file, int line) {
+        appendTimestamp(out, time);
+        out.push_back(' ');
+        out.append(getLevelString(level));
+        out.push_back(' ');
+        out.append(message);
+        if (truncated) {
+            out.append(" ...");
+        }
+        if (file && line > 0) {
+            fmt::format_to(std::back_inserter(out), " [{}:{}]", file, line);
+        }
+        out.push_back('\n');
+    }
 
-    // 获取当前时间戳
-    std::string getCurrentTimestamp() {
-        auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-        
-        std::tm tm_now;
-        localtime_r(&time_t_now, &tm_now);
-        
-        std::ostringstream oss;
-        oss << std::put_time(&tm_now, "%Y-%m-%d %H:%M:%S");
-        oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-        
-        return oss.str();
+    // 追加时间戳，精确到毫秒；日期和时分秒部分每秒只格式化一次（每个线程各自缓存）
+    static void appendTimestamp(std::string& out, std::chrono::system_clock::time_point time) {
+        thread_local time_t cachedSecond = -1;
+        thread_local char cachedText[32];
+        thread_local size_t cachedLength = 0;
+
+        time_t second = std::chrono::system_clock::to_time_t(time);
+        if (second != cachedSecond) {
+            std::tm tm_now;
+            localtime_r(&second, &tm_now);
+            cachedLength = std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &tm_now);
+            cachedSecond = second;
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000;
+        out.append(cachedText, cachedLength);
+        fmt::format_to(std::back_inserter(out), ".{:03}", ms.count());
     }
 
     // 将日志级别转换为字符串
-    std::string getLevelString(LogLevel level) {
+    static const char* getLevelString(LogLevel level) {
         switch (level) {
             case LogLevel::DEBUG:   return "[DEBUG]";
             case LogLevel::INFO:    return "[INFO] ";
@@ -157,11 +438,41 @@ private:
     LogLevel minLogLevel;
     bool enableLogging{true};      // 是否启用日志记录
     bool enableConsoleOutput{true}; // 是否在控制台输出
+
+    // 异步模式
+    std::atomic<bool> async{false};
+    std::atomic<int> producers{0};     // 正在放入记录的线程数，见tryEnqueue
+    size_t ringCapacity{8192};
+    std::chrono::milliseconds flushInterval{100};
+    OverflowPolicy overflowPolicy{OverflowPolicy::Drop};
+    mutable std::mutex registryMutex;  // 只在线程首次登记、后台线程取记录和统计丢弃数时加锁
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> wakeRequested{false};
+    bool stopping{false};
+    std::thread writerThread;
 };
 
-// 宏简化日志调用
-#define LOG_DEBUG(msg) Logger::getInstance().debug(msg, __FILE__, __LINE__)
-#define LOG_INFO(msg) Logger::getInstance().info(msg, __FILE__, __LINE__)
-#define LOG_WARNING(msg) Logger::getInstance().warning(msg, __FILE__, __LINE__)
-#define LOG_ERROR(msg) Logger::getInstance().error(msg, __FILE__, __LINE__)
-#define LOG_FATAL(msg) Logger::getInstance().fatal(msg, __FILE__, __LINE__)
+// 编译期最低日志级别（0=DEBUG ... 4=FATAL），低于该级别的日志调用连同参数求值一起被编译掉
+// Release构建默认为1（不含DEBUG），可用-DLOG_COMPILE_LEVEL=N覆盖
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// 日志宏：LOG_INFO("处理请求: {} {}", method, path)
+// 先检查运行时级别，只有需要输出时才格式化；格式字符串和参数在编译期检查
+#define LOG_AT_LEVEL(level, ...)                                                        \
+    do {                                                                                \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILE_LEVEL) {                   \
+            if (Logger::getInstance().shouldLog(level)) {                               \
+                Logger::getInstance().logFormat(level, __FILE__, __LINE__, __VA_ARGS__); \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT_LEVEL(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT_LEVEL(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT_LEVEL(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT_LEVEL(LogLevel::ERROR, __VA_ARGS__)
+#define LOG_FATAL(...) LOG_AT_LEVEL(LogLevel::FATAL, __VA_ARGS__)
@@ -0,0 +1,200 @@
+#pragma once
+#include <dirent.h>
+#include <sys/resource.h>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
+#include "../http/FileService.hpp"
+#include "../utils/EventLoopMonitor.hpp"
+#include "../utils/LatencyHistogram.hpp"
+#include "../utils/PerformanceMonitor.hpp"
+#include "Logger.hpp"
+
+// Prometheus文本格式（0.0.4）的指标输出，供/metrics采集
+// 只读取各模块已有的统计（各线程计数器的汇总、缓存统计），请求路径上不加锁
+class Metrics {
+public:
+    static constexpr std::string_view CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+    // 渲染全部指标到out（先清空；调用方复用同一个缓冲区，容量在多次采集之间保留）
+    static void render(std::string& out) {
+        out.clear();
+        auto& monitor = PerformanceMonitor::getInstance();
+        auto stats = monitor.snapshot();
+
+        header(out, "httpserver_requests_total", "counter", "Completed HTTP requests by status class.");
+        for (size_t i = 1; i < stats.statusClasses.size(); ++i) {
+            fmt::format_to(std::back_inserter(out), "httpserver_requests_total{{code=\"{}xx\"}} {}\n",
+                           i, stats.statusClasses[i]);
+        }
+        gauge(out, "httpserver_requests_in_flight", "Requests currently being processed.", stats.activeRequests());
+        counter(out, "httpserver_connections_total", "Accepted connections.", stats.connections);
+        gauge(out, "httpserver_connections_active", "Open connections.", stats.activeConnections());
+        counter(out, "httpserver_received_bytes_total", "Bytes read from clients.", stats.bytesIn);
+        counter(out, "httpserver_sent_bytes_total", "Bytes written to clients.", stats.bytesOut);
+
+        // 请求处理时间：启动以来的累计直方图，按路由、方法、状态类别分组
+        header(out, "httpserver_request_duration_seconds", "histogram",
+               "Request processing time by route, method and status class.");
+        if (monitor.isEnabled()) {
+            auto series = monitor.collectLatency(0);
+            for (size_t i = 1; i < series.size(); ++i) {
+                std::string labels = fmt::format("route=\"{}\",method=\"{}\",code=\"{}xx\"",
+                    escapeLabel(series[i].route), series[i].method, series[i].statusClass);
+                histogram(out, "httpserver_request_duration_seconds", labels, series[i].histogram);
+            }
+        }
+
+        // 请求各阶段耗时：读取请求、加载排队、文件读取、缓存查找、处理函数、首字节、发送
+        header(out, "httpserver_request_phase_seconds", "histogram", "Time spent in each request phase.");
+        if (monitor.isEnabled()) {
+            for (size_t phase = 0; phase < RequestTimeline::PHASE_COUNT; ++phase) {
+                HistogramSnapshot h;
+                monitor.collectPhase(static_cast<RequestTimeline::Phase>(phase), 0, h);
+                histogram(out, "httpserver_request_phase_seconds",
+                          fmt::format("phase=\"{}\"", RequestTimeline::PHASE_NAMES[phase]), h);
+            }
+        }
+
+        // 文件缓存各层
+        auto cache = FileService::getInstance().getCacheStats();
+        header(out, "httpserver_cache_hits_total", "counter", "File cache hits by tier.");
+        tier(out, "httpserver_cache_hits_total", cache.small.hits, cache.mapped.hits, cache.openFiles.hits);
+        header(out, "httpserver_cache_misses_total", "counter", "File cache misses by tier.");
+        tier(out, "httpserver_cache_misses_total", cache.small.misses, cache.mapped.misses, cache.openFiles.misses);
+        header(out, "httpserver_cache_evictions_total", "counter", "File cache evictions by tier.");
+        tier(out, "httpserver_cache_evictions_total", cache.small.evictions, cache.mapped.evictions);
+        header(out, "httpserver_cache_entries", "gauge", "File cache entries by tier.");
+        tier(out, "httpserver_cache_entries", cache.small.entries, cache.mapped.entries, cache.openFiles.entries);
+        header(out, "httpserver_cache_bytes", "gauge", "Bytes held by the file cache by tier.");
+        tier(out, "httpserver_cache_bytes", cache.small.bytes, cache.mapped.bytes);
+
+        // 事件循环：唤醒次数、每次唤醒的事件数、每轮处理时间、调度延迟和最长单次恢复
+        auto& loop = EventLoopMonitor::getInstance();
+        counter(out, "httpserver_event_loop_wakeups_total", "epoll_wait returns.", loop.getWakeupCount());
+        counter(out, "httpserver_event_loop_idle_wakeups_total", "epoll_wait returns with no events.",
+                loop.getIdleWakeupCount());
+        counter(out, "httpserver_event_loop_full_wakeups_total", "epoll_wait returns that filled the event batch.",
+                loop.getFullWakeupCount());
+        counter(out, "httpserver_event_loop_resumes_total", "Coroutine resumes.", loop.getResumeCount());
+        counter(out, "httpserver_event_loop_stalls_total", "Watchdog reports of a blocked event loop.",
+                loop.getStallCount());
+        gauge(out, "httpserver_event_loop_batch_size", "Current epoll_wait event batch size.", loop.getBatchCapacity());
+        header(out, "httpserver_event_loop_events", "histogram", "Events returned per non-empty epoll_wait.");
+        header(out, "httpserver_event_loop_iteration_seconds", "histogram",
+               "Time spent processing the events of one epoll_wait return.");
+        header(out, "httpserver_event_loop_lag_seconds", "histogram",
+               "Time from an event becoming ready (epoll_wait returning) to its coroutine resuming.");
+        if (loop.isEnabled()) {
+            HistogramSnapshot sizes, iterations, lag;
+            loop.collectBatchSizes(0, sizes);
+            histogram(out, "httpserver_event_loop_events", {}, sizes, EVENT_BUCKETS, 1);
+            loop.collectIterations(0, iterations);
+            histogram(out, "httpserver_event_loop_iteration_seconds", {}, iterations);
+            loop.collectLag(0, lag);
+            histogram(out, "httpserver_event_loop_lag_seconds", {}, lag);
+            auto [longest, route] = loop.getLongestResume();
+            header(out, "httpserver_event_loop_longest_resume_seconds", "gauge",
+                   "Longest single coroutine resume and the route it served.");
+            if (!route.empty()) {
+                fmt::format_to(std::back_inserter(out), "httpserver_event_loop_longest_resume_seconds{{route=\"{}\"}} {}\n",
+                               escapeLabel(route), longest / 1e6);
+            }
+        }
+
+        counter(out, "httpserver_log_dropped_total", "Log records dropped because an async log buffer was full.",
+                Logger::getInstance().getDroppedCount());
+
+        // 文件描述符使用量
+        gauge(out, "process_open_fds", "Number of open file descriptors.", countOpenFds());
+        struct rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+            gauge(out, "process_max_fds", "Maximum number of open file descriptors.", limit.rlim_cur);
+        }
+    }
+
+private:
+    // 直方图桶的上界（秒），延迟统计以微秒记录
+    static constexpr double BUCKETS[] = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                         0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+    // 每次唤醒事件数的桶上界
+    static constexpr double EVENT_BUCKETS[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+
+    static void header(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+        fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    }
+
+    static void counter(std::string& out, std::string_view name, std::string_view help, uint64_t value) {
+        header(out, name, "counter", help);
+        fmt::format_to(std::back_inserter(out), "{} {}\n", name, value);
+    }
+
+    static void gauge(std::string& out, std::string_view name, std::string_view help, uint64_t value) {
+        header(out, name, "gauge", help);
+        fmt::format_to(std::back_inserter(out), "{} {}\n", name, value);
+    }
+
+    // 三层缓存：小文件缓存、映射缓存、文件描述符缓存（没有的统计项不输出）
+    static void tier(std::string& out, std::string_view name, uint64_t small, uint64_t mapped) {
+        fmt::format_to(std::back_inserter(out), "{0}{{tier=\"small\"}} {1}\n{0}{{tier=\"mapped\"}} {2}\n",
+                       name, small, mapped);
+    }
+
+    static void tier(std::string& out, std::string_view name, uint64_t small, uint64_t mapped, uint64_t openFiles) {
+        tier(out, name, small, mapped);
+        fmt::format_to(std::back_inserter(out), "{}{{tier=\"fd\"}} {}\n", name, openFiles);
+    }
+
+    // 输出累积桶、_sum和_count；snapshot中的值除以scale得到输出单位（默认微秒转为秒）
+    static void histogram(std::string& out, std::string_view name, std::string_view labels,
+                          const HistogramSnapshot& snapshot, std::span<const double> bounds = BUCKETS,
+                          double scale = 1e6) {
+        std::string_view separator = labels.empty() ? "" : ",";
+        for (double bound : bounds) {
+            fmt::format_to(std::back_inserter(out), "{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, separator,
+                           bound, snapshot.countAtOrBelow(static_cast<uint64_t>(bound * scale)));
+        }
+        fmt::format_to(std::back_inserter(out), "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, separator,
+                       snapshot.getCount());
+        std::string_view braceOpen = labels.empty() ? "" : "{";
+        std::string_view braceClose = labels.empty() ? "" : "}";
+        fmt::format_to(std::back_inserter(out), "{0}_sum{1}{2}{3} {4}\n{0}_count{1}{2}{3} {5}\n",
+                       name, braceOpen, labels, braceClose, snapshot.getSum() / scale, snapshot.getCount());
+    }
+
+    // 标签值中的反斜杠、双引号和换行需要转义
+    static std::string escapeLabel(std::string_view value) {
+        std::string result;
+        result.reserve(value.size());
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                result.push_back('\\');
+                result.push_back(c);
+            } else if (c == '\n') {
+                result.append("\\n");
+            } else {
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+
+    static uint64_t countOpenFds() {
+        DIR* dir = opendir("/proc/self/fd");
+        if (dir == nullptr) {
+            return 0;
+        }
+        uint64_t count = 0;
+        while (struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                ++count;
+            }
+        }
+        closedir(dir);
+        return count > 0 ? count - 1 : 0; // 不计opendir自己打开的描述符
+    }
+};
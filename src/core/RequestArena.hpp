@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// 连接级单调内存池：请求和响应状态（解析出的字符串、头部表等）都从这里分配，
+// 每个keep-alive请求结束后整体重置，释放时不逐个归还
+// 初始缓冲区在连接建立时分配一次，普通请求用不完；超出时才向全局堆申请更多块
+class RequestArena {
+public:
+    explicit RequestArena(size_t initialSize)
+        : initialBuffer(std::make_unique<std::byte[]>(initialSize)),
+          resource(initialBuffer.get(), initialSize) {}
+
+    // 删除复制和移动构造/赋值，容器持有resource()的指针
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+    RequestArena(RequestArena&&) = delete;
+    RequestArena& operator=(RequestArena&&) = delete;
+
+    std::pmr::memory_resource* get() {
+        return &resource;
+    }
+
+    // 回到初始缓冲区的起点；调用前所有从中分配的对象必须已被销毁或重置为空
+    void reset() {
+        resource.release();
+    }
+
+private:
+    std::unique_ptr<std::byte[]> initialBuffer;
+    std::pmr::monotonic_buffer_resource resource;
+};
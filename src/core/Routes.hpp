@@ -0,0 +1,226 @@
+#pragma once
+#include "../http/Router.hpp"
+#include "../http/FileService.hpp"
+#include "../http/CacheWarmer.hpp"
+#include "../http/FileLoader.hpp"
+#include "../http/DirectoryListing.hpp"
+#include "../utils/PerformanceMonitor.hpp"
+#include "../utils/Profiler.hpp"
+#include "../network/AsyncIO.hpp"
+#include "ConnectionManager.hpp"
+#include "Metrics.hpp"
+#include "Config.hpp"
+#include "Logger.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+// 服务器内置的路由处理函数，启动时注册到Router
+class Routes {
+public:
+    // 注册全部内置路由：状态页、服务器信息、POST回显，静态文件服务挂载在根路径
+    static void registerAll(Router& router) {
+        router.add("*", "/server-status", serverStatus);
+        router.add("GET", "/server-status/latency", latencyJson);
+        router.add("GET", "/server-status/connections", connectionTable);
+        router.add("*", "/server-info", serverInfo);
+        router.add("GET", "/metrics", metrics);
+        // 采样分析器默认不注册，需要时在配置中打开
+        if (Config::getInstance().getBool("enable_profiler", false)) {
+            router.add("GET", "/debug/profile", profile);
+        }
+        router.add("POST", "/*path", echoPost);
+        router.mount("/", staticFile);
+    }
+
+private:
+    // 解析查询参数中的非负整数，缺失或无效时返回默认值
+    static size_t parseSizeParam(std::string_view value, size_t defaultValue) {
+        size_t result;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        return (ec == std::errc() && ptr == value.data() + value.size()) ? result : defaultValue;
+    }
+
+    // 显示服务器状态
+    static SubTask serverStatus(RequestContext& ctx) {
+        ctx.response.setStatus(200);
+        ctx.response.setContentType("text/plain; charset=UTF-8");
+        ctx.response.setBody(PerformanceMonitor::getInstance().getStatsSummary() +
+                             FileService::getInstance().getCacheSummary() +
+                             EventLoopMonitor::getInstance().getStatusSummary() +
+                             FileLoader::getInstance().getStatusSummary() +
+                             CacheWarmer::getInstance().getStatusSummary());
+        co_return;
+    }
+
+    // 延迟分位数（JSON），供监控系统采集
+    static SubTask latencyJson(RequestContext& ctx) {
+        ctx.response.setStatus(200);
+        ctx.response.setContentType("application/json");
+        ctx.response.setBody(PerformanceMonitor::getInstance().getLatencyJson());
+        co_return;
+    }
+
+    // 连接表：?sort=字段&limit=N按字段降序列出前N个连接，?format=json输出JSON
+    static SubTask connectionTable(RequestContext& ctx) {
+        auto& manager = ConnectionManager::getInstance();
+        std::string_view sort = ctx.request.getParam("sort");
+        if (sort.empty()) {
+            sort = ConnectionTable::DEFAULT_SORT;
+        }
+        ctx.response.setContentType("text/plain; charset=UTF-8");
+        if (!manager.isStatsEnabled()) {
+            ctx.response.setStatus(404);
+            ctx.response.setBody("连接统计未启用（connection_stats=false）\n");
+            co_return;
+        }
+        if (!ConnectionTable::isSortKey(sort)) {
+            ctx.response.setStatus(400);
+            ctx.response.setBody(fmt::format("未知的排序字段: {}，可选: {}\n", sort, ConnectionTable::sortKeys()));
+            co_return;
+        }
+        bool json = ctx.request.getParam("format") == "json";
+        auto entries = manager.collectStats();
+        ctx.response.setStatus(200);
+        if (json) {
+            ctx.response.setContentType("application/json");
+        }
+        ctx.response.setBody(ConnectionTable::render(entries, sort, parseSizeParam(ctx.request.getParam("limit"), 20), json));
+    }
+
+    // Prometheus文本格式的指标，渲染缓冲区在多次采集之间复用
+    static SubTask metrics(RequestContext& ctx) {
+        thread_local std::string buffer;
+        Metrics::render(buffer);
+        ctx.response.setStatus(200);
+        ctx.response.setContentType(Metrics::CONTENT_TYPE);
+        ctx.response.setBody(buffer);
+        co_return;
+    }
+
+    // CPU采样：/debug/profile?seconds=N&hz=M，采样期间挂起等待，结束后返回折叠栈（text/plain）
+    // 同一时间只允许一次采样，已有采样在进行时返回503
+    static SubTask profile(RequestContext& ctx) {
+        auto& config = Config::getInstance();
+        size_t maxSeconds = std::max(config.getInt("profiler_max_seconds", 60), 1);
+        size_t seconds = std::clamp<size_t>(parseSizeParam(ctx.request.getParam("seconds"), 10), 1, maxSeconds);
+        int hz = static_cast<int>(std::clamp<size_t>(
+            parseSizeParam(ctx.request.getParam("hz"), config.getInt("profiler_hz", 99)), 1, 1000));
+
+        Profiler& profiler = Profiler::getInstance();
+        if (!profiler.start(hz, seconds)) {
+            ctx.response.setStatus(503);
+            ctx.response.setContentType("text/plain; charset=UTF-8");
+            ctx.response.setBody("已有采样正在进行或采样启动失败\n");
+            co_return;
+        }
+        // 等待期间连接被关闭、协程被销毁时也要停止采样
+        struct StopOnExit {
+            ~StopOnExit() { Profiler::getInstance().stop(); }
+        } stopOnExit;
+
+        co_await SleepAwaiter(std::chrono::seconds(seconds), ctx.epollFd);
+        ctx.noteResumed();
+        ctx.response.setStatus(200);
+        ctx.response.setContentType("text/plain; charset=UTF-8");
+        ctx.response.setBody(profiler.stop());
+    }
+
+    // 服务器信息
+    static SubTask serverInfo(RequestContext& ctx) {
+        std::string info = "C++20 HTTP服务器\n";
+        info += "版本: 1.0.0\n";
+        info += fmt::format("配置文件: {}\n", Config::getInstance().getString("config_file", "server.conf"));
+        info += fmt::format("根目录: {}\n", Config::getInstance().getString("root_dir", "./www"));
+        info += fmt::format("监听地址: {}:{}\n", Config::getInstance().getString("host", "127.0.0.1"), Config::getInstance().getString("port", "8080"));
+        info += fmt::format("允许目录列表: {}\n", Config::getInstance().getBool("allow_directory_listing", false) ? "是" : "否");
+
+        ctx.response.setStatus(200);
+        ctx.response.setContentType("text/plain; charset=UTF-8");
+        ctx.response.setBody(info);
+        co_return;
+    }
+
+    // 简单的POST请求处理
+    static SubTask echoPost(RequestContext& ctx) {
+        ctx.response.setStatus(200);
+        ctx.response.setContentType("text/plain; charset=UTF-8");
+        ctx.response.setBody(fmt::format("收到POST请求，请求体内容: {}", ctx.request.body()));
+        co_return;
+    }
+
+    // 静态文件服务（GET和HEAD）
+    static SubTask staticFile(RequestContext& ctx) {
+        std::string_view method = ctx.request.method();
+        std::string_view path = ctx.request.path();
+        bool headOnly = method == "HEAD";
+        bool acceptGzip = ctx.request.getHeader("Accept-Encoding").find("gzip") != std::string::npos;
+        // 缓存未命中时挂起，等待加载线程读取文件（同一文件的并发未命中共享一次加载）
+        auto fileResponse = co_await FileFetchAwaiter(path, headOnly, acceptGzip, ctx.timeline);
+        ctx.noteResumed();
+        ctx.response.setStatus(fileResponse.statusCode);
+
+        if (fileResponse.listing) {
+            co_await sendListing(ctx, std::move(fileResponse.listing), headOnly);
+        } else if (fileResponse.owner) {
+            // 预序列化的响应（缓存或内容包），HEAD请求只发送头部
+            std::string_view body = headOnly ? std::string_view{} : fileResponse.body;
+            ctx.response.setPrebuilt(fileResponse.header, body, std::move(fileResponse.owner));
+            if (!headOnly && fileResponse.fileFd != -1) {
+                // 大文件在头部之后流式发送
+                ctx.response.setFileBody(fileResponse.fileFd, fileResponse.fileSize);
+            }
+        } else if (fileResponse.statusCode == 200) {
+            // 使用文件服务提供的MIME类型
+            ctx.response.setContentType(fileResponse.mimeType);
+            LOG_DEBUG("文件 {} 的MIME类型: {}", path, fileResponse.mimeType);
+
+            // HEAD请求设置Content-Length但不发送正文
+            if (headOnly) {
+                ctx.response.setContentLength(fileResponse.content.length());
+            } else {
+                ctx.response.setBody(fileResponse.content);
+            }
+        } else {
+            // 404/403/500等错误页面
+            ctx.setErrorPage(fileResponse.statusCode, headOnly);
+        }
+    }
+
+    // 目录列表：?format=json或Accept为JSON时输出JSON，?page=&per_page=分页
+    // 头部发送后边生成边发送，每块约32KB，块之间让出事件循环，超大目录不会独占事件循环
+    static SubTask sendListing(RequestContext& ctx, std::shared_ptr<const DirectoryListing> listing, bool headOnly) {
+        auto& request = ctx.request;
+        bool json = request.getParam("format") == "json" ||
+                    request.getHeader("Accept").find("application/json") != std::string::npos;
+        size_t pageSize = parseSizeParam(request.getParam("per_page"),
+            Config::getInstance().getInt("directory_listing_page_size", 0));
+        DirectoryListingWriter writer(std::move(listing), std::string(request.path()),
+            json ? DirectoryListingWriter::Format::Json : DirectoryListingWriter::Format::Html,
+            parseSizeParam(request.getParam("page"), 1), pageSize);
+
+        ctx.response.setStatus(200);
+        ctx.response.setContentType(writer.contentType());
+        ctx.response.setChunked();
+        co_await ctx.send();
+        if (headOnly) {
+            co_return;
+        }
+
+        constexpr size_t LISTING_CHUNK_SIZE = 32 * 1024;
+        std::string chunk;
+        while (!writer.finished()) {
+            chunk.clear();
+            while (chunk.size() < LISTING_CHUNK_SIZE && writer.next(chunk)) {
+            }
+            ctx.response.setChunk(chunk, writer.finished());
+            co_await ctx.send();
+            if (!writer.finished()) {
+                co_await ctx.yield();
+            }
+        }
+    }
+};
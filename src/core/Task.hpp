@@ -1,6 +1,9 @@
 #pragma once
+#include <array>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <new>
 #include <fmt/format.h>
 
 // 简单的任务类，表示一个无返回值的协程
@@ -56,4 +59,146 @@ public:
     }
     
     std::coroutine_handle<promise_type> handle;
-};
\ No newline at end of file
+};
+
+// 协程帧缓存：按64字节分级的线程局部空闲链表，释放的帧留给下一个同等级的协程复用
+// 每个请求都会创建处理函数、发送响应等子任务，预热后不再向全局堆申请帧
+// 超过最大等级的帧直接使用全局堆；每级最多缓存MAX_CACHED个，多余的归还全局堆
+class FrameCache {
+public:
+    static constexpr size_t GRANULARITY = 64;
+    static constexpr size_t CLASS_COUNT = 32;  // 最大缓存2KB的帧
+    static constexpr size_t MAX_CACHED = 64;
+
+    static void* allocate(size_t size) {
+        size_t classIndex = classFor(size);
+        if (classIndex >= CLASS_COUNT) {
+            return ::operator new(size);
+        }
+        FreeList& list = instance().lists[classIndex];
+        if (list.head != nullptr) {
+            Node* node = list.head;
+            list.head = node->next;
+            --list.count;
+            return node;
+        }
+        return ::operator new((classIndex + 1) * GRANULARITY);
+    }
+
+    static void deallocate(void* frame, size_t size) noexcept {
+        size_t classIndex = classFor(size);
+        if (classIndex >= CLASS_COUNT) {
+            ::operator delete(frame);
+            return;
+        }
+        FreeList& list = instance().lists[classIndex];
+        if (list.count >= MAX_CACHED) {
+            ::operator delete(frame);
+            return;
+        }
+        list.head = new (frame) Node{list.head};
+        ++list.count;
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    struct FreeList {
+        Node* head = nullptr;
+        size_t count = 0;
+    };
+
+    ~FrameCache() {
+        for (FreeList& list : lists) {
+            while (list.head != nullptr) {
+                Node* node = list.head;
+                list.head = node->next;
+                ::operator delete(node);
+            }
+        }
+    }
+
+    static FrameCache& instance() {
+        static thread_local FrameCache cache;
+        return cache;
+    }
+
+    static size_t classFor(size_t size) {
+        return size == 0 ? 0 : (size - 1) / GRANULARITY;
+    }
+
+    std::array<FreeList, CLASS_COUNT> lists;
+};
+
+// 可被co_await的子任务：创建时不执行，被等待时才开始，结束后恢复等待者（对称转移）
+// 协程体内的异常保存下来，在等待者的co_await处重新抛出
+class SubTask {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+        
+        // 协程帧从线程局部的帧缓存分配，见FrameCache
+        static void* operator new(size_t size) {
+            return FrameCache::allocate(size);
+        }
+        static void operator delete(void* frame, size_t size) noexcept {
+            FrameCache::deallocate(frame, size);
+        }
+        
+        SubTask get_return_object() {
+            return SubTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        
+        // 结束时直接切换回等待者，同步完成的子任务不会加深调用栈
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        
+        void return_void() {}
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+    
+    explicit SubTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    SubTask(SubTask&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+    
+    // 禁止复制和移动赋值
+    SubTask(const SubTask&) = delete;
+    SubTask& operator=(const SubTask&) = delete;
+    SubTask& operator=(SubTask&&) = delete;
+    
+    ~SubTask() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+    
+    bool await_ready() const noexcept { return false; }
+    
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle.promise().continuation = caller;
+        return handle;
+    }
+    
+    void await_resume() {
+        if (handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+    
+private:
+    std::coroutine_handle<promise_type> handle;
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "FileService.hpp"
+#include "../core/Config.hpp"
+#include "../core/Logger.hpp"
+
+namespace fs = std::filesystem;
+
+// 缓存预热：启动时在后台并行预加载上次记录的热点文件（或整个根目录），
+// 并定期把当前热点文件按访问频率写入清单，供下次重启使用
+class CacheWarmer {
+public:
+    enum class State { Disabled, Running, Ready };
+
+    static CacheWarmer& getInstance() {
+        static CacheWarmer instance;
+        return instance;
+    }
+
+    // 读取配置并启动预热和热点清单保存线程
+    void start() {
+        auto& config = Config::getInstance();
+        manifestPath = config.getString("hotset_file", "hotset.manifest");
+        saveInterval = std::chrono::seconds(config.getInt("hotset_save_interval", 60));
+
+        if (FileService::getInstance().hasContentPack()) {
+            // 内容包已映射到内存，无需预热
+            LOG_INFO("已加载内容包，跳过缓存预热");
+        } else if (config.getBool("cache_warmup", false)) {
+            state = State::Running;
+            startTime = std::chrono::steady_clock::now();
+            size_t threadCount = std::max(config.getInt("cache_warmup_threads", 4), 1);
+            warmupThread = std::thread([this, threadCount] { runWarmup(threadCount); });
+        }
+
+        if (saveInterval.count() > 0) {
+            saverThread = std::thread([this] { runSaver(); });
+        }
+    }
+
+    // 停止后台线程，并在退出前保存一次热点清单
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        stopCondition.notify_all();
+        if (warmupThread.joinable()) {
+            warmupThread.join();
+        }
+        if (saverThread.joinable()) {
+            saverThread.join();
+            saveManifest();
+        }
+    }
+
+    // 预热进度摘要，显示在/server-status中
+    std::string getStatusSummary() const {
+        switch (state.load()) {
+            case State::Disabled:
+                return "缓存预热: 未启用\n";
+            case State::Running:
+                return fmt::format("缓存预热: 进行中 ({}/{} 个文件, {:.1f}MB)\n",
+                    processedFiles.load(), totalFiles.load(), loadedBytes.load() / (1024.0 * 1024));
+            case State::Ready:
+            default:
+                return fmt::format("缓存预热: 完成 ({}/{} 个文件, {:.1f}MB, 用时 {}ms)\n",
+                    processedFiles.load(), totalFiles.load(), loadedBytes.load() / (1024.0 * 1024),
+                    durationMs.load());
+        }
+    }
+
+private:
+    CacheWarmer() = default;
+    ~CacheWarmer() {
+        stop();
+    }
+
+    // 删除复制和移动构造/赋值
+    CacheWarmer(const CacheWarmer&) = delete;
+    CacheWarmer& operator=(const CacheWarmer&) = delete;
+    CacheWarmer(CacheWarmer&&) = delete;
+    CacheWarmer& operator=(CacheWarmer&&) = delete;
+
+    // 优先使用上次保存的热点清单，不存在时预加载整个根目录
+    std::vector<std::string> collectCandidates() {
+        std::vector<std::string> paths;
+        std::ifstream manifest(manifestPath);
+        if (manifest.is_open()) {
+            std::string line;
+            while (std::getline(manifest, line)) {
+                if (!line.empty() && line[0] != '#') {
+                    paths.push_back(line);
+                }
+            }
+            LOG_INFO("从热点清单 {} 读取 {} 个文件", manifestPath, paths.size());
+            return paths;
+        }
+
+        const std::string& rootDir = FileService::getInstance().getRootDirectory();
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(rootDir, fs::directory_options::skip_permission_denied, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec)) {
+                paths.push_back(fs::relative(it->path(), rootDir, ec).generic_string());
+            }
+        }
+        LOG_INFO("热点清单不存在，预加载根目录下 {} 个文件", paths.size());
+        return paths;
+    }
+
+    void runWarmup(size_t threadCount) {
+        std::vector<std::string> paths = collectCandidates();
+        totalFiles = paths.size();
+
+        // 多个线程从共享下标领取任务，达到缓存容量后停止
+        auto& fileService = FileService::getInstance();
+        size_t budget = fileService.getMaxCacheSize();
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            while (!stopping && loadedBytes.load(std::memory_order_relaxed) < budget) {
+                size_t index = next.fetch_add(1);
+                if (index >= paths.size()) break;
+                loadedBytes += fileService.preloadFile(paths[index]);
+                processedFiles++;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < std::min(threadCount, paths.size()); ++i) {
+            workers.emplace_back(worker);
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+
+        durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        state = State::Ready;
+        LOG_INFO("缓存预热完成: {}/{} 个文件, {:.1f}MB, 用时 {}ms",
+            processedFiles.load(), totalFiles.load(), loadedBytes.load() / (1024.0 * 1024), durationMs.load());
+    }
+
+    // 定期保存热点清单
+    void runSaver() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (stopCondition.wait_for(lock, saveInterval, [this] { return stopping.load(); })) {
+                break;
+            }
+            lock.unlock();
+            saveManifest();
+            lock.lock();
+        }
+    }
+
+    // 先写临时文件再重命名，避免崩溃时留下不完整的清单
+    void saveManifest() {
+        // 预热尚未完成时缓存内容不代表真实热度，跳过保存
+        if (state.load() == State::Running) {
+            return;
+        }
+        std::vector<std::string> hotSet = FileService::getInstance().getHotSet();
+        if (hotSet.empty()) {
+            return;
+        }
+
+        std::string tempPath = manifestPath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::trunc);
+            if (!out.is_open()) {
+                LOG_WARNING("无法写入热点清单: {}", tempPath);
+                return;
+            }
+            out << "# 热点文件清单，按访问频率从高到低排序\n";
+            for (const auto& path : hotSet) {
+                out << path << '\n';
+            }
+        }
+        if (std::rename(tempPath.c_str(), manifestPath.c_str()) != 0) {
+            LOG_WARNING("无法保存热点清单: {}", manifestPath);
+            return;
+        }
+        LOG_DEBUG("热点清单已保存: {} 个文件", hotSet.size());
+    }
+
+    std::string manifestPath;
+    std::chrono::seconds saveInterval{60};
+
+    std::atomic<State> state{State::Disabled};
+    std::atomic<size_t> totalFiles{0};
+    std::atomic<size_t> processedFiles{0};
+    std::atomic<size_t> loadedBytes{0};
+    std::atomic<long> durationMs{0};
+    std::chrono::steady_clock::time_point startTime;
+
+    std::mutex mutex;
+    std::condition_variable stopCondition;
+    std::atomic<bool> stopping{false};
+    std::thread warmupThread;
+    std::thread saverThread;
+};
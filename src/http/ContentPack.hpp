@@ -0,0 +1,181 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+
+// 只读内容包：由ContentPacker工具把整个根目录打包成单个文件，
+// 包含按路径排序的索引、预先生成的响应头部块（MIME类型、验证器）和可选的gzip版本
+// 服务器直接mmap该文件，命中时不产生任何文件系统调用，多个进程共享同一份页缓存
+class ContentPack {
+public:
+    static constexpr char MAGIC[8] = {'H', 'W', 'S', 'P', 'A', 'C', 'K', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    // 文件格式：Header | 条目表(Entry[entryCount]，按路径排序) | 路径、头部块与内容数据
+    // 所有偏移量相对于文件开头
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t entryCount;
+        uint64_t entriesOffset;
+        uint64_t fileSize;
+    };
+
+    // 一个编码版本：预序列化的头部块和内容
+    struct Variant {
+        uint64_t headerOffset;
+        uint64_t bodyOffset;
+        uint64_t bodyLength;
+        uint32_t headerLength;
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        uint64_t pathOffset;
+        uint32_t pathLength;
+        uint32_t flags;
+        Variant identity;
+        Variant gzip;
+    };
+
+    static constexpr uint32_t FLAG_GZIP = 1; // 存在gzip压缩版本
+
+    // 查找结果，视图指向映射内存，在ContentPack销毁前有效
+    struct Response {
+        std::string_view header;
+        std::string_view body;
+    };
+
+    ContentPack() = default;
+
+    ~ContentPack() {
+        if (data != nullptr) {
+            ::munmap(const_cast<char*>(data), length);
+        }
+    }
+
+    // 删除复制和移动构造/赋值
+    ContentPack(const ContentPack&) = delete;
+    ContentPack& operator=(const ContentPack&) = delete;
+    ContentPack(ContentPack&&) = delete;
+    ContentPack& operator=(ContentPack&&) = delete;
+
+    // 映射并校验内容包
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            LOG_ERROR("无法打开内容包 {}: {}", path, strerror(errno));
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            LOG_ERROR("内容包无效: {}", path);
+            ::close(fd);
+            return false;
+        }
+        length = st.st_size;
+        void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("无法映射内容包 {}: {}", path, strerror(errno));
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+
+        if (!validate()) {
+            LOG_ERROR("内容包格式错误或已损坏: {}", path);
+            ::munmap(const_cast<char*>(data), length);
+            data = nullptr;
+            return false;
+        }
+        // 索引在每次查找时都会访问，提前读入
+        ::madvise(const_cast<char*>(data), header()->entriesOffset + entryCount() * sizeof(Entry), MADV_WILLNEED);
+        LOG_INFO("内容包已加载: {} ({} 个文件, {:.1f}MB)", path, entryCount(), length / (1024.0 * 1024));
+        return true;
+    }
+
+    // 按相对路径（不含开头的/）二分查找，未找到返回nullptr
+    const Entry* find(std::string_view path) const {
+        const Entry* begin = entries();
+        const Entry* end = begin + entryCount();
+        const Entry* it = std::lower_bound(begin, end, path,
+            [this](const Entry& entry, std::string_view key) { return pathOf(entry) < key; });
+        if (it == end || pathOf(*it) != path) {
+            return nullptr;
+        }
+        return it;
+    }
+
+    // 客户端接受gzip且存在压缩版本时返回压缩版本
+    Response get(const Entry& entry, bool acceptGzip) const {
+        const Variant& variant = (acceptGzip && (entry.flags & FLAG_GZIP)) ? entry.gzip : entry.identity;
+        return {std::string_view(data + variant.headerOffset, variant.headerLength),
+                std::string_view(data + variant.bodyOffset, variant.bodyLength)};
+    }
+
+    std::string_view pathOf(const Entry& entry) const {
+        return std::string_view(data + entry.pathOffset, entry.pathLength);
+    }
+
+    uint32_t entryCount() const {
+        return header()->entryCount;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const Header* header() const {
+        return reinterpret_cast<const Header*>(data);
+    }
+
+    const Entry* entries() const {
+        return reinterpret_cast<const Entry*>(data + header()->entriesOffset);
+    }
+
+    bool inBounds(uint64_t offset, uint64_t size) const {
+        return offset <= length && size <= length - offset;
+    }
+
+    // 打开时一次性校验所有偏移，之后的查找无需边界检查
+    bool validate() const {
+        const Header* h = header();
+        if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION ||
+            h->fileSize != length || h->entriesOffset % alignof(Entry) != 0 ||
+            !inBounds(h->entriesOffset, static_cast<uint64_t>(h->entryCount) * sizeof(Entry))) {
+            return false;
+        }
+        const Entry* list = entries();
+        for (uint32_t i = 0; i < h->entryCount; ++i) {
+            const Entry& entry = list[i];
+            if (!inBounds(entry.pathOffset, entry.pathLength) ||
+                !inBounds(entry.identity.headerOffset, entry.identity.headerLength) ||
+                !inBounds(entry.identity.bodyOffset, entry.identity.bodyLength)) {
+                return false;
+            }
+            if ((entry.flags & FLAG_GZIP) &&
+                (!inBounds(entry.gzip.headerOffset, entry.gzip.headerLength) ||
+                 !inBounds(entry.gzip.bodyOffset, entry.gzip.bodyLength))) {
+                return false;
+            }
+            // 二分查找要求路径严格递增
+            if (i > 0 && !(pathOf(list[i - 1]) < pathOf(entry))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* data{nullptr};
+    size_t length{0};
+};
@@ -0,0 +1,368 @@
+#pragma once
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+// 目录内容快照：读取一次并排序（目录在前，按名称排序），之后的请求直接复用
+// 类型取自readdir的d_type（即directory_entry缓存的类型），普通文件为取得大小、类型未知或符号链接时才stat
+// 快照在文件加载线程中读取，目录很大时逐项stat也不会阻塞事件循环
+struct DirectoryListing {
+    struct Entry {
+        std::string name;
+        bool isDirectory;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+
+    // 从已打开的目录fd读取快照，fd的所有权转移给此函数；失败返回nullptr
+    static std::shared_ptr<const DirectoryListing> read(int dirFd) {
+        DIR* dir = ::fdopendir(dirFd);
+        if (dir == nullptr) {
+            ::close(dirFd);
+            return nullptr;
+        }
+        auto listing = std::make_shared<DirectoryListing>();
+        while (const struct dirent* entry = ::readdir(dir)) {
+            std::string_view name(entry->d_name);
+            if (name == "." || name == "..") {
+                continue;
+            }
+            bool isDirectory = entry->d_type == DT_DIR;
+            uint64_t size = 0;
+            if (entry->d_type == DT_REG || entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                // 只有文件大小需要stat，每个快照只做一次；符号链接按目标类型显示
+                struct stat st;
+                if (::fstatat(::dirfd(dir), entry->d_name, &st, 0) == 0) {
+                    isDirectory = S_ISDIR(st.st_mode);
+                    size = S_ISREG(st.st_mode) ? st.st_size : 0;
+                }
+            }
+            listing->entries.push_back(Entry{std::string(name), isDirectory, size});
+        }
+        ::closedir(dir);
+
+        std::sort(listing->entries.begin(), listing->entries.end(), [](const Entry& a, const Entry& b) {
+            if (a.isDirectory != b.isDirectory) return a.isDirectory;
+            return a.name < b.name;
+        });
+        return listing;
+    }
+};
+
+// 目录列表缓存，以相对根目录的目录路径为键；目录内容变化时由文件监视失效，另有TTL兜底
+class DirectoryListingCache {
+public:
+    void configure(std::chrono::seconds ttl, size_t maxEntries) {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->ttl = ttl;
+        this->maxEntries = maxEntries;
+        entries.clear();
+    }
+
+    std::shared_ptr<const DirectoryListing> lookup(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        if (it->second.expires <= std::chrono::steady_clock::now()) {
+            entries.erase(it);
+            return nullptr;
+        }
+        return it->second.listing;
+    }
+
+    void insert(const std::string& path, std::shared_ptr<const DirectoryListing> listing) {
+        if (maxEntries == 0) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.size() >= maxEntries && entries.find(path) == entries.end()) {
+            // 先清理过期条目，仍然满时随意淘汰一个
+            std::erase_if(entries, [now](const auto& item) { return item.second.expires <= now; });
+            if (entries.size() >= maxEntries) {
+                entries.erase(entries.begin());
+            }
+        }
+        entries[path] = Item{std::move(listing), now + ttl};
+    }
+
+    void invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.erase(path);
+    }
+
+    // 使某个目录下的所有条目失效
+    void invalidatePrefix(std::string_view prefix) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::erase_if(entries, [prefix](const auto& item) {
+            return std::string_view(item.first).substr(0, prefix.size()) == prefix;
+        });
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+private:
+    struct Item {
+        std::shared_ptr<const DirectoryListing> listing;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Item> entries;
+    std::chrono::seconds ttl{30};
+    size_t maxEntries{256};
+};
+
+// 把目录快照的一页逐段输出为HTML或JSON，每段最多ENTRIES_PER_STEP个条目，
+// 超大目录的列表边生成边发送，不会一次在内存中生成整个页面
+class DirectoryListingWriter {
+public:
+    enum class Format { Html, Json };
+
+    static constexpr size_t ENTRIES_PER_STEP = 64;
+
+    // page从1开始，pageSize为0时不分页
+    DirectoryListingWriter(std::shared_ptr<const DirectoryListing> listing, std::string requestPath,
+                           Format format, size_t page, size_t pageSize)
+        : listing(std::move(listing)), requestPath(std::move(requestPath)), format(format),
+          page(std::max<size_t>(page, 1)), pageSize(pageSize) {
+        if (this->requestPath.empty() || this->requestPath.back() != '/') {
+            this->requestPath += '/';
+        }
+        size_t total = this->listing->entries.size();
+        if (pageSize == 0) {
+            position = 0;
+            end = total;
+        } else {
+            position = std::min((this->page - 1) * pageSize, total);
+            end = std::min(position + pageSize, total);
+        }
+        first = position;
+    }
+
+    const char* contentType() const {
+        return format == Format::Json ? "application/json; charset=UTF-8" : "text/html; charset=UTF-8";
+    }
+
+    bool finished() const {
+        return stage == Stage::Done;
+    }
+
+    // 生成下一段输出，追加到out；全部输出完毕后返回false
+    bool next(std::string& out) {
+        switch (stage) {
+        case Stage::Head:
+            format == Format::Json ? writeJsonHead(out) : writeHtmlHead(out);
+            stage = Stage::Entries;
+            return true;
+        case Stage::Entries: {
+            size_t chunkEnd = std::min(position + ENTRIES_PER_STEP, end);
+            for (; position < chunkEnd; ++position) {
+                format == Format::Json ? writeJsonEntry(out, listing->entries[position])
+                                       : writeHtmlEntry(out, listing->entries[position]);
+            }
+            if (position == end) {
+                stage = Stage::Tail;
+            }
+            return true;
+        }
+        case Stage::Tail:
+            format == Format::Json ? writeJsonTail(out) : writeHtmlTail(out);
+            stage = Stage::Done;
+            return true;
+        case Stage::Done:
+            break;
+        }
+        return false;
+    }
+
+    // HTML转义，用于文本和属性值
+    static void appendHtmlEscaped(std::string& out, std::string_view text) {
+        for (char c : text) {
+            switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&#39;"; break;
+            default: out += c;
+            }
+        }
+    }
+
+    // 百分号编码，用于链接中的文件名（保留"/"）
+    static void appendUrlEncoded(std::string& out, std::string_view text) {
+        static constexpr char HEX[] = "0123456789ABCDEF";
+        for (unsigned char c : text) {
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+                out += static_cast<char>(c);
+            } else {
+                out += '%';
+                out += HEX[c >> 4];
+                out += HEX[c & 0x0F];
+            }
+        }
+    }
+
+    // JSON字符串转义（不含两侧引号）
+    static void appendJsonEscaped(std::string& out, std::string_view text) {
+        for (unsigned char c : text) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    fmt::format_to(std::back_inserter(out), "\\u{:04x}", c);
+                } else {
+                    out += static_cast<char>(c);
+                }
+            }
+        }
+    }
+
+private:
+    enum class Stage { Head, Entries, Tail, Done };
+
+    static std::string formatSize(uint64_t size) {
+        if (size < 1024) {
+            return fmt::format("{} B", size);
+        } else if (size < 1024 * 1024) {
+            return fmt::format("{:.1f} KB", size / 1024.0);
+        } else if (size < 1024 * 1024 * 1024) {
+            return fmt::format("{:.1f} MB", size / (1024.0 * 1024));
+        }
+        return fmt::format("{:.1f} GB", size / (1024.0 * 1024 * 1024));
+    }
+
+    // 上级目录路径，根目录返回空
+    std::string parentPath() const {
+        if (requestPath == "/") {
+            return "";
+        }
+        size_t pos = requestPath.find_last_of('/', requestPath.size() - 2);
+        return requestPath.substr(0, pos + 1);
+    }
+
+    size_t pageCount() const {
+        return pageSize == 0 ? 1 : std::max<size_t>((listing->entries.size() + pageSize - 1) / pageSize, 1);
+    }
+
+    void writeHtmlHead(std::string& out) {
+        out += "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n<title>目录列表: ";
+        appendHtmlEscaped(out, requestPath);
+        out += "</title>\n"
+               "<style>\n"
+               "body { font-family: Arial, sans-serif; margin: 20px; }\n"
+               "h1 { color: #333; }\n"
+               "ul { list-style-type: none; padding: 0; }\n"
+               "li { margin: 5px 0; }\n"
+               "a { text-decoration: none; color: #0066cc; }\n"
+               "a:hover { text-decoration: underline; }\n"
+               ".directory { font-weight: bold; }\n"
+               "</style>\n</head>\n<body>\n<h1>目录: ";
+        appendHtmlEscaped(out, requestPath);
+        out += "</h1>\n<ul>\n";
+
+        std::string parent = parentPath();
+        if (!parent.empty()) {
+            out += "<li><a href=\"";
+            appendUrlEncoded(out, parent);
+            out += "\">..</a> (上级目录)</li>\n";
+        }
+    }
+
+    void writeHtmlEntry(std::string& out, const DirectoryListing::Entry& entry) {
+        out += entry.isDirectory ? "<li><a class=\"directory\" href=\"" : "<li><a href=\"";
+        appendUrlEncoded(out, requestPath);
+        appendUrlEncoded(out, entry.name);
+        if (entry.isDirectory) {
+            out += '/';
+        }
+        out += "\">";
+        appendHtmlEscaped(out, entry.name);
+        if (entry.isDirectory) {
+            out += "/</a></li>\n";
+        } else {
+            out += "</a> (";
+            out += formatSize(entry.size);
+            out += ")</li>\n";
+        }
+    }
+
+    void writeHtmlTail(std::string& out) {
+        out += "</ul>\n";
+        if (pageSize != 0 && pageCount() > 1) {
+            out += "<p>";
+            if (page > 1) {
+                fmt::format_to(std::back_inserter(out), "<a href=\"?page={}&amp;per_page={}\">上一页</a> ", page - 1, pageSize);
+            }
+            fmt::format_to(std::back_inserter(out), "第 {}/{} 页，共 {} 项", page, pageCount(), listing->entries.size());
+            if (page < pageCount()) {
+                fmt::format_to(std::back_inserter(out), " <a href=\"?page={}&amp;per_page={}\">下一页</a>", page + 1, pageSize);
+            }
+            out += "</p>\n";
+        }
+        out += "<hr>\n<p>C++20 HTTP Server</p>\n</body>\n</html>";
+    }
+
+    void writeJsonHead(std::string& out) {
+        out += "{\"path\":\"";
+        appendJsonEscaped(out, requestPath);
+        fmt::format_to(std::back_inserter(out), "\",\"total\":{},\"page\":{},\"per_page\":{},\"entries\":[",
+                       listing->entries.size(), page, pageSize);
+    }
+
+    void writeJsonEntry(std::string& out, const DirectoryListing::Entry& entry) {
+        if (position != first) {
+            out += ',';
+        }
+        out += "{\"name\":\"";
+        appendJsonEscaped(out, entry.name);
+        if (entry.isDirectory) {
+            out += "\",\"type\":\"directory\"}";
+        } else {
+            fmt::format_to(std::back_inserter(out), "\",\"type\":\"file\",\"size\":{}}}", entry.size);
+        }
+    }
+
+    void writeJsonTail(std::string& out) {
+        out += "]}";
+    }
+
+    std::shared_ptr<const DirectoryListing> listing;
+    std::string requestPath;
+    Format format;
+    size_t page;
+    size_t pageSize;
+    size_t first{0};
+    size_t position{0};
+    size_t end{0};
+    Stage stage{Stage::Head};
+};
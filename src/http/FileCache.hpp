@@ -0,0 +1,339 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ResponseCache.hpp"
+
+// Count-Min Sketch频率估计器，计数饱和于15，定期减半以反映近期热度
+// 计数器为原子变量，查找路径只需宽松原子操作，无需加锁
+class FrequencySketch {
+public:
+    void init(size_t capacity) {
+        width = 64;
+        while (width < capacity * 2) {
+            width <<= 1;
+        }
+        table = std::make_unique<std::atomic<uint8_t>[]>(width * DEPTH);
+        sampleSize = std::max<size_t>(capacity * 10, 64);
+        additions.store(0, std::memory_order_relaxed);
+    }
+
+    void increment(uint64_t hash) {
+        if (!table) return;
+        for (size_t i = 0; i < DEPTH; ++i) {
+            auto& counter = table[i * width + indexOf(hash, i)];
+            uint8_t value = counter.load(std::memory_order_relaxed);
+            while (value < MAX_COUNT &&
+                   !counter.compare_exchange_weak(value, value + 1, std::memory_order_relaxed)) {
+            }
+        }
+        if (additions.fetch_add(1, std::memory_order_relaxed) + 1 >= sampleSize) {
+            halve();
+        }
+    }
+
+    uint8_t estimate(uint64_t hash) const {
+        if (!table) return 0;
+        uint8_t result = MAX_COUNT;
+        for (size_t i = 0; i < DEPTH; ++i) {
+            result = std::min(result, table[i * width + indexOf(hash, i)].load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t DEPTH = 4;
+    static constexpr uint8_t MAX_COUNT = 15;
+    static constexpr uint64_t SEEDS[DEPTH] = {
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0x27D4EB2F165667C5ULL
+    };
+
+    size_t indexOf(uint64_t hash, size_t row) const {
+        uint64_t h = hash * SEEDS[row];
+        return static_cast<size_t>(h ^ (h >> 32)) & (width - 1);
+    }
+
+    // 所有计数减半（老化），与并发的increment竞争是无害的
+    void halve() {
+        additions.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < width * DEPTH; ++i) {
+            table[i].store(table[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+        }
+    }
+
+    std::unique_ptr<std::atomic<uint8_t>[]> table;
+    size_t width{0};
+    size_t sampleSize{0};
+    std::atomic<size_t> additions{0};
+};
+
+// 分片文件缓存：条目为不可变的引用计数响应，查找只持有共享锁
+// 每个分片由一个小的准入窗口(FIFO)和主区(CLOCK)组成，窗口溢出的条目
+// 需要在频率估计上胜过主区的淘汰候选才能进入主区（W-TinyLFU），
+// 因此一次性的全站扫描无法冲掉热点数据
+class FileCache {
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t insertions;
+        size_t evictions;
+        size_t rejections;
+        size_t entries;
+        size_t bytes;
+    };
+
+    FileCache() {
+        configure(100 * 1024 * 1024, 1000, 16);
+    }
+
+    // 设置缓存容量，会清空现有内容
+    void configure(size_t maxBytes, size_t maxEntries, size_t shardCount) {
+        shardCount = std::max<size_t>(shardCount, 1);
+        shards.clear();
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto shard = std::make_unique<Shard>();
+            // 窗口占分片容量的1%，其余归主区
+            size_t shardBytes = std::max<size_t>(maxBytes / shardCount, 2);
+            shard->windowBudget = std::max<size_t>(shardBytes / 100, 1);
+            shard->mainBudget = shardBytes - shard->windowBudget;
+            shard->maxEntries = std::max<size_t>((maxEntries + shardCount - 1) / shardCount, 1);
+            shard->maxWindowEntries = std::max<size_t>(shard->maxEntries / 100, 1);
+            shard->sketch.init(shard->maxEntries);
+            shard->hand = shard->main.end();
+            shards.push_back(std::move(shard));
+        }
+    }
+
+    // 查找缓存项，返回共享的不可变响应，未命中返回nullptr
+    std::shared_ptr<const CachedResponse> lookup(std::string_view key) const {
+        uint64_t hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        shard.sketch.increment(hash);
+
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        it->second->referenced.store(true, std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
+    }
+
+    // 插入或替换缓存项，返回是否被缓存
+    bool insert(const std::string& key, std::shared_ptr<const CachedResponse> value) {
+        uint64_t hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        size_t size = value->body.size();
+
+        std::unique_lock lock(shard.mutex);
+        if (auto it = shard.index.find(key); it != shard.index.end()) {
+            removeNode(shard, it->second);
+        }
+        if (size > shard.mainBudget) {
+            rejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // 新条目先进入准入窗口
+        shard.window.emplace_front(key, std::move(value), size, hash);
+        auto node = shard.window.begin();
+        node->inWindow = true;
+        shard.index.emplace(node->key, node);
+        shard.windowBytes += size;
+        insertions.fetch_add(1, std::memory_order_relaxed);
+
+        // 窗口溢出的条目参与主区准入竞争
+        bool cached = true;
+        while (!shard.window.empty() &&
+               (shard.windowBytes > shard.windowBudget || shard.window.size() > shard.maxWindowEntries)) {
+            auto candidate = std::prev(shard.window.end());
+            bool isNewNode = (candidate == node);
+            if (!admitToMain(shard, candidate) && isNewNode) {
+                cached = false;
+            }
+        }
+        return cached;
+    }
+
+    // 使单个缓存项失效
+    void invalidate(std::string_view key) {
+        Shard& shard = shardFor(hashOf(key));
+        std::unique_lock lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            removeNode(shard, it->second);
+        }
+    }
+
+    // 使某个目录下的所有缓存项失效（目录被移动或删除时使用）
+    void invalidatePrefix(std::string_view prefix) {
+        for (auto& shard : shards) {
+            std::unique_lock lock(shard->mutex);
+            for (auto it = shard->index.begin(); it != shard->index.end();) {
+                auto node = (it++)->second;
+                if (std::string_view(node->key).substr(0, prefix.size()) == prefix) {
+                    removeNode(*shard, node);
+                }
+            }
+        }
+    }
+
+    // 检查是否已缓存，不影响访问频率和命中统计
+    bool contains(std::string_view key) const {
+        Shard& shard = shardFor(hashOf(key));
+        std::shared_lock lock(shard.mutex);
+        return shard.index.find(key) != shard.index.end();
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            std::unique_lock lock(shard->mutex);
+            shard->index.clear();
+            shard->window.clear();
+            shard->main.clear();
+            shard->hand = shard->main.end();
+            shard->windowBytes = 0;
+            shard->mainBytes = 0;
+        }
+    }
+
+    // 导出当前缓存的键及其访问频率估计，按频率从高到低排序
+    std::vector<std::pair<std::string, uint8_t>> snapshot() const {
+        std::vector<std::pair<std::string, uint8_t>> result;
+        for (const auto& shard : shards) {
+            std::shared_lock lock(shard->mutex);
+            for (const auto& [key, node] : shard->index) {
+                result.emplace_back(node->key, shard->sketch.estimate(node->hash));
+            }
+        }
+        std::stable_sort(result.begin(), result.end(),
+            [](const auto& a, const auto& b) { return a.second > b.second; });
+        return result;
+    }
+
+    Stats getStats() const {
+        Stats stats{hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed),
+                    insertions.load(std::memory_order_relaxed), evictions.load(std::memory_order_relaxed),
+                    rejections.load(std::memory_order_relaxed), 0, 0};
+        for (const auto& shard : shards) {
+            std::shared_lock lock(shard->mutex);
+            stats.entries += shard->index.size();
+            stats.bytes += shard->windowBytes + shard->mainBytes;
+        }
+        return stats;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        std::shared_ptr<const CachedResponse> value;
+        size_t size;
+        uint64_t hash;
+        bool inWindow{false};
+        mutable std::atomic<bool> referenced{false};
+
+        Node(std::string key, std::shared_ptr<const CachedResponse> value, size_t size, uint64_t hash)
+            : key(std::move(key)), value(std::move(value)), size(size), hash(hash) {}
+    };
+    using NodeList = std::list<Node>;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        NodeList window;                 // 准入窗口，按插入顺序
+        NodeList main;                   // 主区，CLOCK环
+        NodeList::iterator hand;         // CLOCK指针
+        std::unordered_map<std::string_view, NodeList::iterator> index; // 键指向节点内的key
+        FrequencySketch sketch;
+        size_t windowBytes{0};
+        size_t mainBytes{0};
+        size_t windowBudget{0};
+        size_t mainBudget{0};
+        size_t maxEntries{0};
+        size_t maxWindowEntries{0};
+    };
+
+    static uint64_t hashOf(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    Shard& shardFor(uint64_t hash) const {
+        return *shards[(hash >> 32) % shards.size()];
+    }
+
+    bool mainHasRoom(const Shard& shard, size_t size) const {
+        return shard.mainBytes + size <= shard.mainBudget &&
+               shard.main.size() + shard.window.size() <= shard.maxEntries;
+    }
+
+    // CLOCK：跳过并清除最近被访问过的条目，返回第一个未被访问的条目
+    NodeList::iterator selectVictim(Shard& shard) {
+        while (true) {
+            if (shard.hand == shard.main.end()) {
+                shard.hand = shard.main.begin();
+            }
+            if (!shard.hand->referenced.exchange(false, std::memory_order_relaxed)) {
+                return shard.hand;
+            }
+            ++shard.hand;
+        }
+    }
+
+    // 窗口尾部条目与主区淘汰候选比较访问频率，胜出者留在缓存中
+    bool admitToMain(Shard& shard, NodeList::iterator candidate) {
+        shard.windowBytes -= candidate->size;
+        if (!mainHasRoom(shard, candidate->size) && !shard.main.empty()) {
+            auto victim = selectVictim(shard);
+            if (shard.sketch.estimate(candidate->hash) <= shard.sketch.estimate(victim->hash)) {
+                shard.index.erase(candidate->key);
+                shard.window.erase(candidate);
+                rejections.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            while (!shard.main.empty() && !mainHasRoom(shard, candidate->size)) {
+                removeNode(shard, selectVictim(shard));
+                evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // 插入到CLOCK指针之前，即最后才会被扫描到的位置
+        candidate->inWindow = false;
+        candidate->referenced.store(false, std::memory_order_relaxed);
+        shard.main.splice(shard.hand, shard.window, candidate);
+        shard.mainBytes += candidate->size;
+        return true;
+    }
+
+    void removeNode(Shard& shard, NodeList::iterator node) {
+        shard.index.erase(node->key);
+        if (node->inWindow) {
+            shard.windowBytes -= node->size;
+            shard.window.erase(node);
+        } else {
+            if (shard.hand == node) {
+                ++shard.hand;
+            }
+            shard.mainBytes -= node->size;
+            shard.main.erase(node);
+        }
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    mutable std::atomic<size_t> hits{0};
+    mutable std::atomic<size_t> misses{0};
+    std::atomic<size_t> insertions{0};
+    std::atomic<size_t> evictions{0};
+    std::atomic<size_t> rejections{0};
+};
@@ -0,0 +1,299 @@
+#pragma once
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include "FileService.hpp"
+#include "../core/Logger.hpp"
+#include "../utils/RequestTimeline.hpp"
+
+// 文件加载器：缓存未命中的文件在后台线程中读取，事件循环不会阻塞在磁盘I/O上
+// 同一路径的并发未命中合并为一次加载（single-flight），第一个请求者发起加载，
+// 其余请求者挂起等待，加载完成后全部以同一份共享的缓存条目恢复
+// 完成通知经eventfd送回事件循环，由事件循环线程恢复等待的协程
+class FileLoader {
+public:
+    struct Stats {
+        size_t loads;      // 实际发起的加载次数
+        size_t coalesced;  // 合并到进行中加载的请求数
+        size_t inFlight;   // 当前进行中的加载数
+    };
+
+    // 一次进行中的加载，只在事件循环线程中访问（result由加载线程在入队完成前写入）
+    struct Flight {
+        std::string key;
+        std::string path;
+        bool headOnly;
+        std::vector<std::coroutine_handle<>> waiters;
+        std::optional<FileService::FileResponse> result;
+        // 入队、加载线程取出、加载完成的时间，用于统计排队和读取耗时
+        std::chrono::steady_clock::time_point enqueued;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point finished;
+    };
+
+    static FileLoader& getInstance() {
+        static FileLoader instance;
+        return instance;
+    }
+
+    // 创建eventfd并启动加载线程；threadCount为0时不启用，未命中在事件循环中同步加载
+    bool init(size_t threadCount) {
+        if (threadCount == 0) {
+            return false;
+        }
+        eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd == -1) {
+            LOG_ERROR("文件加载器eventfd创建失败: {}", strerror(errno));
+            return false;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { runWorker(); });
+        }
+        LOG_INFO("文件加载器已启动，加载线程数: {}", threadCount);
+        return true;
+    }
+
+    bool isEnabled() const {
+        return eventFd != -1;
+    }
+
+    int getFd() const {
+        return eventFd;
+    }
+
+    // 加入对path的加载：已有进行中的加载时只登记等待者，否则发起新的加载
+    // 只能在事件循环线程中调用
+    std::shared_ptr<Flight> join(const std::string& path, bool headOnly, std::coroutine_handle<> waiter) {
+        // GET和HEAD的结果不同（HEAD不读取内容），分开合并
+        std::string key = (headOnly ? "H" : "G") + path;
+        auto it = inFlight.find(key);
+        if (it != inFlight.end()) {
+            it->second->waiters.push_back(waiter);
+            coalesced++;
+            return it->second;
+        }
+
+        auto flight = std::make_shared<Flight>();
+        flight->key = std::move(key);
+        flight->path = path;
+        flight->headOnly = headOnly;
+        flight->waiters.push_back(waiter);
+        flight->enqueued = std::chrono::steady_clock::now();
+        inFlight.emplace(flight->key, flight);
+        loads++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(flight);
+        }
+        pendingCondition.notify_one();
+        return flight;
+    }
+
+    // 文件变化后在后台把它重新加载到缓存，不等待结果；只能在事件循环线程中调用
+    // 变化之前发起的同路径加载可能读到旧内容（其缓存写入会因代数变化被放弃），不与之合并，
+    // 之后未命中的请求合并到这次加载
+    void reload(const std::string& path) {
+        auto flight = std::make_shared<Flight>();
+        flight->key = "G" + path;
+        flight->path = path;
+        flight->headOnly = false;
+        flight->enqueued = std::chrono::steady_clock::now();
+        inFlight[flight->key] = flight;
+        loads++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(flight));
+        }
+        pendingCondition.notify_one();
+    }
+
+    // 处理已完成的加载并恢复等待的协程，在事件循环线程中eventfd可读时调用
+    void processCompletions() {
+        uint64_t counter;
+        while (::read(eventFd, &counter, sizeof(counter)) == -1 && errno == EINTR) {
+        }
+
+        std::vector<std::shared_ptr<Flight>> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(completed);
+        }
+        for (auto& flight : done) {
+            // 先移出进行中表，恢复的协程再次未命中时会发起新的加载而不是加入已完成的这次
+            // 同一个键可能已被之后的重新加载替换，只移除自己
+            auto it = inFlight.find(flight->key);
+            if (it != inFlight.end() && it->second == flight) {
+                inFlight.erase(it);
+            }
+            auto waiters = std::move(flight->waiters);
+            for (auto waiter : waiters) {
+                waiter.resume();
+            }
+        }
+    }
+
+    // 停止加载线程，未完成的加载不再通知
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pendingCondition.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers.clear();
+    }
+
+    Stats getStats() const {
+        return Stats{loads, coalesced, inFlight.size()};
+    }
+
+    std::string getStatusSummary() const {
+        if (!isEnabled()) {
+            return "";
+        }
+        return fmt::format("文件加载: 加载 {} 次, 合并请求 {} 次, 进行中 {}\n",
+                           loads, coalesced, inFlight.size());
+    }
+
+    ~FileLoader() {
+        stop();
+        if (eventFd != -1) {
+            ::close(eventFd);
+        }
+    }
+
+private:
+    FileLoader() = default;
+
+    // 删除复制和移动构造/赋值
+    FileLoader(const FileLoader&) = delete;
+    FileLoader& operator=(const FileLoader&) = delete;
+    FileLoader(FileLoader&&) = delete;
+    FileLoader& operator=(FileLoader&&) = delete;
+
+    void runWorker() {
+        auto& fileService = FileService::getInstance();
+        while (true) {
+            std::shared_ptr<Flight> flight;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                pendingCondition.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (stopping) {
+                    return;
+                }
+                flight = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            flight->started = std::chrono::steady_clock::now();
+            flight->result = fileService.loadFileContent(flight->path, flight->headOnly);
+            flight->finished = std::chrono::steady_clock::now();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed.push_back(std::move(flight));
+            }
+            uint64_t one = 1;
+            while (::write(eventFd, &one, sizeof(one)) == -1 && errno == EINTR) {
+            }
+        }
+    }
+
+    int eventFd{-1};
+    std::vector<std::thread> workers;
+
+    // 以下只在事件循环线程中访问
+    std::unordered_map<std::string, std::shared_ptr<Flight>> inFlight;
+    size_t loads{0};
+    size_t coalesced{0};
+
+    // 以下由mutex保护
+    std::mutex mutex;
+    std::condition_variable pendingCondition;
+    std::deque<std::shared_ptr<Flight>> pending;
+    std::vector<std::shared_ptr<Flight>> completed;
+    bool stopping{false};
+};
+
+// 获取文件响应的awaitable：缓存命中（包括由元数据缓存回答的404和HEAD）时不挂起；
+// 需要读取文件时加入（或发起）该路径的加载，
+// 加载完成后以共享的结果恢复。未启用加载器时在当前线程同步加载
+// 传入timeline时记录缓存查找、加载排队和文件读取的耗时
+class FileFetchAwaiter {
+public:
+    // path是指向请求的视图，在co_await结束前必须保持有效
+    FileFetchAwaiter(std::string_view path, bool headOnly, bool acceptGzip, RequestTimeline* timeline = nullptr)
+        : path(path), headOnly(headOnly), acceptGzip(acceptGzip), timeline(timeline) {}
+
+    bool await_ready() {
+        using Clock = RequestTimeline::Clock;
+        auto& fileService = FileService::getInstance();
+        Clock::time_point start = timeline ? Clock::now() : Clock::time_point{};
+        result = fileService.lookupCached(path, headOnly, acceptGzip);
+        if (timeline) {
+            timeline->looked = true;
+            timeline->cacheLookupNanos += RequestTimeline::nanosBetween(start, Clock::now());
+        }
+        if (result) {
+            return true;
+        }
+        if (!FileLoader::getInstance().isEnabled()) {
+            Clock::time_point loadStart = timeline ? Clock::now() : Clock::time_point{};
+            result = fileService.loadFileContent(std::string(path), headOnly);
+            if (timeline) {
+                timeline->loaded = true;
+                timeline->fileIoNanos += RequestTimeline::nanosBetween(loadStart, Clock::now());
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        flight = FileLoader::getInstance().join(std::string(path), headOnly, h);
+        if (timeline) {
+            timeline->pauseHandler();
+        }
+    }
+
+    FileService::FileResponse await_resume() {
+        if (result) {
+            return std::move(*result);
+        }
+        if (timeline) {
+            timeline->resumeHandler();
+            timeline->loaded = true;
+            timeline->queueWaitNanos += RequestTimeline::nanosBetween(flight->enqueued, flight->started);
+            timeline->fileIoNanos += RequestTimeline::nanosBetween(flight->started, flight->finished);
+        }
+        // 多个等待者共享同一份结果，各自复制（缓存条目本身由owner共享，不复制内容）
+        return *flight->result;
+    }
+
+private:
+    std::string_view path;
+    bool headOnly;
+    bool acceptGzip;
+    RequestTimeline* timeline;
+    std::optional<FileService::FileResponse> result;
+    std::shared_ptr<FileLoader::Flight> flight;
+};
@@ -3,33 +3,31 @@
 #include <unordered_map>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <chrono>
-#include <mutex>
 #include <optional>
 #include <vector>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include "ContentPack.hpp"
+#include "DirectoryListing.hpp"
+#include "FileCache.hpp"
+#include "MetadataCache.hpp"
+#include "OpenFileCache.hpp"
+#include "RootDirectory.hpp"
+#include "SlabArena.hpp"
+#include "ResponseCache.hpp"
 #include "../core/Logger.hpp"
 #include "../core/Config.hpp"
 
 namespace fs = std::filesystem;
 
-// 文件缓存项
-struct CacheEntry {
-    std::string content;
-    std::string mimeType;
-    std::chrono::steady_clock::time_point lastAccess;
-    size_t size;
-    
-    CacheEntry(std::string content, std::string mimeType)
-        : content(std::move(content)), mimeType(std::move(mimeType)), 
-          lastAccess(std::chrono::steady_clock::now()), size(this->content.size()) {}
-    
-    void updateLastAccess() {
-        lastAccess = std::chrono::steady_clock::now();
-    }
-};
-
 class FileService {
 public:
     static FileService& getInstance() {
@@ -41,22 +39,50 @@ public:
     bool init(const std::string& rootDir) {
         rootDirectory = rootDir;
         
-        // 检查根目录是否存在且可访问
-        if (!fs::exists(rootDirectory) || !fs::is_directory(rootDirectory)) {
-            LOG_ERROR(fmt::format("根目录不存在或无法访问: {}", rootDirectory));
+        // 打开根目录，之后所有文件都相对它解析
+        if (!root.open(rootDirectory)) {
             return false;
         }
         
-        // 初始化MIME类型映射
-        initMimeTypes();
-        
         // 从配置中读取缓存设置
+        // 小文件层：内容存放在连续的内存池中；中等文件层：只读文件映射；更大的文件流式发送
         auto& config = Config::getInstance();
+        size_t shards = config.getInt("file_cache_shards", 16);
         maxCacheSize = config.getInt("file_cache_max_size", 100) * 1024 * 1024; // 默认100MB
         maxCacheEntries = config.getInt("file_cache_max_entries", 1000);
-        maxCacheFileSize = config.getInt("file_cache_max_file_size", 5) * 1024 * 1024; // 默认最大文件5MB
+        maxSmallFileSize = config.getInt("cache_small_file_max_size", 64) * 1024; // 默认64KB
+        smallCache.configure(maxCacheSize, maxCacheEntries, shards);
+        arena = SlabArena::create(maxCacheSize, maxSmallFileSize, config.getBool("cache_use_huge_pages", true));
+        if (!arena) {
+            LOG_WARNING("小文件内存池创建失败，小文件将存放在普通堆内存中");
+        }
+        
+        maxMappedCacheSize = static_cast<size_t>(config.getInt("cache_mmap_tier_size", 1024)) * 1024 * 1024; // 默认1GB
+        maxCacheFileSize = static_cast<size_t>(config.getInt("file_cache_max_file_size", 64)) * 1024 * 1024; // 默认64MB
+        if (maxMappedCacheSize == 0) {
+            // 关闭映射层时超过小文件上限的文件全部流式发送
+            maxCacheFileSize = maxSmallFileSize;
+        }
+        mappedCache.configure(maxMappedCacheSize, config.getInt("cache_mmap_max_entries", 1000), shards);
+        openFileCache.configure(config.getInt("open_file_cache_max", 256),
+                                std::chrono::seconds(config.getInt("open_file_cache_valid", 30)));
+        metadataCache.configure(std::chrono::seconds(config.getInt("file_meta_cache_ttl", 30)),
+                                std::chrono::seconds(config.getInt("file_meta_negative_ttl", 5)),
+                                config.getInt("file_meta_cache_max_entries", 10000));
+        listingCache.configure(std::chrono::seconds(config.getInt("directory_listing_cache_ttl", 30)),
+                               config.getInt("directory_listing_cache_max", 256));
+        
+        // 内容包模式：根目录在部署期间只读，直接映射打包好的内容
+        std::string packPath = config.getString("content_pack", "");
+        if (!packPath.empty()) {
+            auto pack = std::make_shared<ContentPack>();
+            if (!pack->open(packPath)) {
+                return false;
+            }
+            contentPack = std::move(pack);
+        }
         
-        LOG_INFO(fmt::format("文件服务初始化完成，根目录: {}", rootDirectory));
+        LOG_INFO("文件服务初始化完成，根目录: {}", rootDirectory);
         return true;
     }
 
@@ -71,97 +97,267 @@ public:
     }
 
     // 根据请求路径获取文件内容
+    // 缓存的文件和内容包中的文件以预序列化的头部块和内容视图返回，由owner保持有效；
+    // 目录列表以共享的目录快照返回，由调用方分块输出
     struct FileResponse {
-        std::string statusCode;
+        int statusCode;
         std::string content;
         std::string mimeType;
+        std::string_view header;
+        std::string_view body;
+        std::shared_ptr<const void> owner;
+        int fileFd{-1};       // 流式发送的大文件，由owner负责关闭
+        size_t fileSize{0};
+        std::shared_ptr<const DirectoryListing> listing;
         
-        FileResponse(std::string status, std::string content = "", std::string mime = "")
-            : statusCode(std::move(status)), content(std::move(content)), mimeType(std::move(mime)) {}
-    };
-    
-    FileResponse getFileContent(const std::string& requestPath) {
-        // 处理路径，防止路径遍历攻击
-        std::string path = sanitizePath(requestPath);
+        FileResponse(int status, std::string content = "", std::string mime = "")
+            : statusCode(status), content(std::move(content)), mimeType(std::move(mime)) {}
         
-        // 确保路径不以"/"开头，因为路径会被拼接到rootDirectory后面
-        if (!path.empty() && path[0] == '/') {
-            path = path.substr(1);
-        }
+        explicit FileResponse(std::shared_ptr<const CachedResponse> response)
+            : statusCode(response->statusCode),
+              header(response->headerBlock), body(response->body), owner(std::move(response)) {}
         
-        // 构建完整路径
-        std::string fullPath = buildFullPath(rootDirectory, path);
+        FileResponse(ContentPack::Response packed, std::shared_ptr<const ContentPack> pack)
+            : statusCode(200), header(packed.header), body(packed.body), owner(std::move(pack)) {}
         
-        // 首先尝试从缓存中获取文件内容
-        auto cachedContent = getCachedContent(fullPath);
-        if (cachedContent.has_value()) {
-            const CacheEntry& entry = cachedContent.value();
-            return {"200", entry.content, entry.mimeType};
+        explicit FileResponse(std::shared_ptr<const DirectoryListing> listing)
+            : statusCode(200), listing(std::move(listing)) {}
+    };
+    
+    // headOnly为true时（HEAD请求）只需要头部，不读取文件内容
+    // acceptGzip为true时优先返回内容包中的gzip压缩版本
+    FileResponse getFileContent(const std::string& requestPath, bool headOnly = false, bool acceptGzip = false) {
+        if (auto cached = lookupCached(requestPath, headOnly, acceptGzip)) {
+            return std::move(*cached);
         }
-        
-        // 检查路径是否存在
-        if (!fs::exists(fullPath)) {
-            // 文件不存在
-            return {"404", "", ""};
+        return loadFileContent(requestPath, headOnly);
+    }
+    
+    // 只查找内容包和内存缓存，不产生任何文件系统调用；未命中返回nullopt
+    // 规范路径直接以视图作为缓存键，命中时不分配内存
+    // 内容未缓存时由元数据缓存回答404和HEAD请求，只有需要读取文件的请求才交给加载路径
+    std::optional<FileResponse> lookupCached(std::string_view requestPath, bool headOnly = false, bool acceptGzip = false) {
+        // 内容包命中时无需路径拼接和任何文件系统调用
+        if (contentPack) {
+            if (auto packed = lookupPacked(requestPath, acceptGzip)) {
+                return packed;
+            }
         }
         
-        // 如果是目录且配置允许列出目录
-        if (fs::is_directory(fullPath) && Config::getInstance().getBool("allow_directory_listing", false)) {
-            // 确保请求路径以/开头
-            std::string absolutePath = path;
-            if (absolutePath.empty() || absolutePath[0] != '/') {
-                absolutePath = "/" + absolutePath;
-            }
-            // 确保路径以/结尾
-            if (!absolutePath.empty() && absolutePath.back() != '/') {
-                absolutePath += '/';
+        std::string key;
+        std::string_view path;
+        if (isCanonicalPath(requestPath)) {
+            path = requestPath.substr(1);
+        } else {
+            key = toCacheKey(std::string(requestPath));
+            path = key;
+        }
+        if (auto cached = getCachedContent(path)) {
+            return FileResponse(std::move(cached));
+        }
+        if (auto listing = listingCache.lookup(std::string(path))) {
+            return FileResponse(std::move(listing));
+        }
+        if (auto metadata = metadataCache.lookup(path)) {
+            switch (metadata->type) {
+                case FileMetadata::Type::Regular:
+                    if (headOnly) {
+                        return FileResponse(buildHeadResponse(*metadata));
+                    }
+                    break;
+                case FileMetadata::Type::Directory:
+                    // 允许目录列表时需要读取目录，交给加载路径
+                    if (!Config::getInstance().getBool("allow_directory_listing", false)) {
+                        return FileResponse(404);
+                    }
+                    break;
+                default:
+                    return FileResponse(404);
             }
-            
-            std::string listing = generateDirectoryListing(fullPath, absolutePath);
-            return {"200", listing, "text/html"};
         }
+        return std::nullopt;
+    }
+    
+    // 缓存未命中时的加载路径：读取元数据和文件内容并放入缓存
+    // 可能阻塞在磁盘I/O上，由文件加载线程调用
+    FileResponse loadFileContent(const std::string& requestPath, bool headOnly = false) {
+        std::string path = toCacheKey(requestPath);
+        // 在读取任何文件之前记下代数，加载期间文件发生变化时放弃写入缓存
+        uint64_t generation = currentGeneration(path);
         
-        // 读取文件内容
         try {
-            if (fs::is_regular_file(fullPath)) {
-                auto fileSize = fs::file_size(fullPath);
-                std::string mimeType = getMimeType(fullPath);
-                
-                // 对于超大文件，不缓存直接读取
-                if (fileSize > maxCacheFileSize) {
-                    auto [status, content] = readLargeFile(fullPath);
-                    return {status, content, mimeType};
+            // 获取元数据：命中时不产生文件系统调用，未命中时只需一次openat2和fstat
+            auto metadata = getMetadata(path, generation);
+            
+            // 如果是目录且配置允许列出目录
+            if (metadata->type == FileMetadata::Type::Directory &&
+                Config::getInstance().getBool("allow_directory_listing", false)) {
+                auto listing = loadDirectoryListing(path, generation);
+                if (!listing) {
+                    return {500, "", ""};
                 }
-                
-                // 读取文件内容并缓存
-                std::string content = readFile(fullPath, fileSize);
-                
-                // 缓存文件内容，如果文件不太大
-                cacheFile(fullPath, content, mimeType);
-                
-                return {"200", content, mimeType};
-            } else {
-                // 不是文件
-                return {"404", "", ""};
+                return FileResponse(std::move(listing));
+            }
+            
+            if (metadata->type != FileMetadata::Type::Regular) {
+                // 不存在或不是文件
+                return {404, "", ""};
+            }
+            
+            // HEAD请求直接由元数据生成头部
+            if (headOnly) {
+                return FileResponse(buildHeadResponse(*metadata));
+            }
+            
+            // 对于超大文件，不缓存，用sendfile流式发送
+            if (metadata->size > maxCacheFileSize) {
+                return openLargeFile(path, *metadata, generation);
             }
+            
+            // 读取文件内容，连同头部块一起序列化
+            auto response = loadFileResponse(path, *metadata, generation);
+            
+            // 缓存文件内容，如果文件不太大
+            cacheFile(path, response, generation);
+            
+            return FileResponse(std::move(response));
         } catch (const std::exception& e) {
             // 服务器错误
-            return {"500", "", ""};
+            return {500, "", ""};
         }
     }
     
     // 清除文件缓存
     void clearCache() {
-        std::lock_guard<std::mutex> lock(cacheMutex);
-        fileCache.clear();
-        currentCacheSize = 0;
+        smallCache.clear();
+        mappedCache.clear();
+        openFileCache.clear();
+        listingCache.clear();
+    }
+    
+    // 各缓存层的统计
+    struct CacheStats {
+        FileCache::Stats small;
+        FileCache::Stats mapped;
+        SlabArena::Stats arena;
+        OpenFileCache::Stats openFiles;
+        size_t streamed;
+    };
+    
+    CacheStats getCacheStats() const {
+        return CacheStats{smallCache.getStats(), mappedCache.getStats(),
+                          arena ? arena->getStats() : SlabArena::Stats{}, openFileCache.getStats(), streamedFiles.load()};
+    }
+    
+    // 缓存分层统计摘要，显示在/server-status中
+    std::string getCacheSummary() const {
+        auto stats = getCacheStats();
+        auto formatTier = [](const char* name, const FileCache::Stats& tier, size_t budget) {
+            size_t lookups = tier.hits + tier.misses;
+            return fmt::format("{}: {} 个文件, {:.1f}/{:.1f}MB, 命中率 {:.1f}%, 淘汰 {}, 拒绝 {}\n",
+                name, tier.entries, tier.bytes / (1024.0 * 1024), budget / (1024.0 * 1024),
+                lookups > 0 ? tier.hits * 100.0 / lookups : 0.0, tier.evictions, tier.rejections);
+        };
+        std::string summary = formatTier("小文件缓存", stats.small, maxCacheSize);
+        if (arena) {
+            // 内部碎片：块大小与实际内容之差；空闲：已切分但未使用的块
+            const auto& a = stats.arena;
+            summary += fmt::format("  内存池: 已切分 {:.1f}MB, 已用 {:.1f}MB, 内部碎片 {:.1f}%, 空闲块 {:.1f}MB, 分配失败 {}, 大页 {}\n",
+                a.committed / (1024.0 * 1024), a.used / (1024.0 * 1024),
+                a.used > 0 ? (a.used - a.requested) * 100.0 / a.used : 0.0,
+                (a.committed - a.used) / (1024.0 * 1024), a.failures, a.hugePages ? "是" : "否");
+        }
+        summary += formatTier("映射缓存", stats.mapped, maxMappedCacheSize);
+        summary += fmt::format("流式发送: {} 次\n", stats.streamed);
+        size_t fdLookups = stats.openFiles.hits + stats.openFiles.misses;
+        summary += fmt::format("文件描述符缓存: {} 个, 命中率 {:.1f}%\n", stats.openFiles.entries,
+            fdLookups > 0 ? stats.openFiles.hits * 100.0 / fdLookups : 0.0);
+        summary += fmt::format("目录列表缓存: {} 个\n", listingCache.size());
+        return summary;
+    }
+    
+    const std::string& getRootDirectory() const {
+        return rootDirectory;
+    }
+    
+    bool hasContentPack() const {
+        return contentPack != nullptr;
+    }
+    
+    size_t getMaxCacheSize() const {
+        return maxCacheSize + maxMappedCacheSize;
+    }
+    
+    // 预加载文件到缓存（缓存预热使用），返回加载的字节数
+    size_t preloadFile(const std::string& relativePath) {
+        // 清单内容来自磁盘，同样需要净化，防止越出根目录
+        std::string path = sanitizePath(relativePath).substr(1);
+        if (smallCache.contains(path) || mappedCache.contains(path)) {
+            return 0;
+        }
+        uint64_t generation = currentGeneration(path);
+        try {
+            auto metadata = getMetadata(path, generation);
+            if (metadata->type == FileMetadata::Type::Regular && metadata->size <= maxCacheFileSize) {
+                auto response = loadFileResponse(path, *metadata, generation);
+                return cacheFile(path, response, generation) ? metadata->size : 0;
+            }
+        } catch (const std::exception& e) {
+            LOG_WARNING("预加载文件失败: {} - {}", path, e.what());
+        }
+        return 0;
+    }
+    
+    // 获取当前热点文件（相对路径），按访问频率从高到低排序
+    std::vector<std::string> getHotSet() {
+        std::vector<std::string> hotSet;
+        auto entries = smallCache.snapshot();
+        auto mapped = mappedCache.snapshot();
+        entries.insert(entries.end(), mapped.begin(), mapped.end());
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.second > b.second; });
+        for (const auto& [key, frequency] : entries) {
+            hotSet.push_back(key);
+        }
+        return hotSet;
+    }
+    
+    // 文件发生变化（由FileWatcher调用），relativePath相对于根目录
+    // 返回变化前该文件是否在缓存中
+    bool invalidateFile(const std::string& relativePath) {
+        bumpGeneration(relativePath);
+        bool wasCached = smallCache.contains(relativePath) || mappedCache.contains(relativePath);
+        smallCache.invalidate(relativePath);
+        mappedCache.invalidate(relativePath);
+        openFileCache.invalidate(relativePath);
+        metadataCache.invalidate(relativePath);
+        listingCache.invalidate(parentOf(relativePath));
+        LOG_DEBUG("文件变化: {} ({})", relativePath, wasCached ? "已失效" : "未缓存");
+        return wasCached;
+    }
+    
+    // 目录被创建、移动或删除，使其自身及其下所有缓存项失效
+    void onDirectoryChanged(const std::string& relativeDir) {
+        bumpAllGenerations();
+        std::string prefix = relativeDir + "/";
+        smallCache.invalidatePrefix(prefix);
+        mappedCache.invalidatePrefix(prefix);
+        openFileCache.invalidatePrefix(prefix);
+        metadataCache.invalidate(relativeDir);
+        metadataCache.invalidatePrefix(prefix);
+        listingCache.invalidate(relativeDir);
+        listingCache.invalidate(parentOf(relativeDir));
+        listingCache.invalidatePrefix(prefix);
+        LOG_DEBUG("目录变化: {}", prefix);
     }
 
 private:
     FileService() {
         // 设置默认文件列表
         defaultFiles = {"index.html", "index.htm", "default.html"};
-        currentCacheSize = 0;
+        
+        // 初始化MIME类型映射（不依赖根目录，打包工具也会用到）
+        initMimeTypes();
     }
     
     // 删除复制和移动构造/赋值
@@ -170,14 +366,180 @@ private:
     FileService(FileService&&) = delete;
     FileService& operator=(FileService&&) = delete;
 
-    // 构建完整路径
-    std::string buildFullPath(const std::string& base, const std::string& relativePath) {
-        std::string fullPath = base;
-        if (!fullPath.empty() && fullPath.back() != '/') {
-            fullPath += '/';
+    // 规范化路径作为缓存键（去掉开头的"/"）；是否越出根目录由内核在打开时检查
+    std::string toCacheKey(const std::string& requestPath) {
+        std::string path = sanitizePath(requestPath);
+        if (!path.empty() && path[0] == '/') {
+            path.erase(0, 1);
+        }
+        return path;
+    }
+    
+    // 在内容包中查找，未找到时（如目录或打包后新增的文件）回退到文件系统
+    std::optional<FileResponse> lookupPacked(std::string_view requestPath, bool acceptGzip) {
+        std::string_view path(requestPath);
+        std::string sanitized;
+        if (!isCanonicalPath(path)) {
+            sanitized = sanitizePath(std::string(requestPath));
+            path = sanitized;
+        }
+        path.remove_prefix(1);
+        
+        const ContentPack::Entry* entry = contentPack->find(path);
+        if (entry == nullptr) {
+            return std::nullopt;
+        }
+        return FileResponse(contentPack->get(*entry, acceptGzip), contentPack);
+    }
+    
+    // 检查路径是否已是规范形式（以/开头，不含空段、"."、".."和反斜杠），
+    // 规范路径无需净化即可直接查找
+    static bool isCanonicalPath(std::string_view path) {
+        if (path.empty() || path[0] != '/') {
+            return false;
+        }
+        size_t start = 1;
+        while (start <= path.size()) {
+            size_t end = path.find('/', start);
+            if (end == std::string_view::npos) {
+                end = path.size();
+            }
+            std::string_view segment = path.substr(start, end - start);
+            if (segment.empty() || segment == "." || segment == ".." ||
+                segment.find('\\') != std::string_view::npos) {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+    
+    // 获取路径的元数据，未缓存时相对根目录打开一次并fstat取得类型、大小和修改时间
+    // 普通文件的fd直接交给文件描述符缓存，随后的读取使用同一个fd，
+    // 不存在先检查后打开之间文件被替换的竞争；越出根目录的路径按不存在处理
+    std::shared_ptr<const FileMetadata> getMetadata(const std::string& relativePath, uint64_t generation) {
+        if (auto metadata = metadataCache.lookup(relativePath)) {
+            return metadata;
         }
-        fullPath += relativePath;
-        return fullPath;
+        
+        FileMetadata metadata;
+        // O_NONBLOCK避免打开FIFO等特殊文件时阻塞
+        int fd = root.openBeneath(relativePath, O_RDONLY | O_NONBLOCK);
+        struct stat st;
+        if (fd != -1 && ::fstat(fd, &st) == 0) {
+            if (S_ISREG(st.st_mode)) {
+                metadata.type = FileMetadata::Type::Regular;
+                metadata.mimeType = getMimeType(relativePath);
+                storeOpenFile(relativePath, fd, st, generation);
+                fd = -1;
+            } else if (S_ISDIR(st.st_mode)) {
+                metadata.type = FileMetadata::Type::Directory;
+            } else {
+                metadata.type = FileMetadata::Type::Other;
+            }
+            metadata.size = st.st_size;
+            metadata.mtime = st.st_mtime;
+        }
+        if (fd != -1) {
+            ::close(fd);
+        }
+        std::lock_guard<std::mutex> lock(generationMutex);
+        if (generationSlot(relativePath) != generation) {
+            return std::make_shared<const FileMetadata>(std::move(metadata));
+        }
+        return metadataCache.store(relativePath, std::move(metadata));
+    }
+    
+    // 读取文件并序列化为可缓存的完整响应
+    // 小文件读入内存池（内存池已满时退回堆内存），中等文件建立只读映射
+    std::shared_ptr<const CachedResponse> loadFileResponse(const std::string& relativePath, const FileMetadata& metadata,
+                                                           uint64_t generation) {
+        std::string validators = ResponseCache::buildValidators(metadata.size, metadata.mtime);
+        if (metadata.size > maxSmallFileSize) {
+            auto [data, storage] = mapFile(relativePath, metadata.size, generation);
+            return ResponseCache::build(200, metadata.mimeType, data, std::move(storage), validators);
+        }
+        if (arena && metadata.size > 0) {
+            if (auto block = arena->allocate(metadata.size)) {
+                std::string_view data(block.get(), readInto(relativePath, block.get(), metadata.size, generation));
+                return ResponseCache::build(200, metadata.mimeType, data, std::move(block), validators);
+            }
+        }
+        return ResponseCache::build(200, metadata.mimeType, readFile(relativePath, metadata.size, generation), validators);
+    }
+    
+    // 通过文件描述符缓存相对根目录打开文件，失败时抛出异常
+    std::shared_ptr<const OpenFile> openFile(const std::string& relativePath, uint64_t generation) {
+        auto file = acquireOpenFile(relativePath, generation);
+        if (!file) {
+            throw std::runtime_error("Cannot open file");
+        }
+        return file;
+    }
+    
+    // 把文件读入调用方提供的缓冲区，返回实际读到的字节数
+    // 使用pread，不改变共享fd的文件偏移
+    size_t readInto(const std::string& relativePath, char* buffer, size_t size, uint64_t generation) {
+        auto file = openFile(relativePath, generation);
+        size_t total = 0;
+        while (total < size) {
+            ssize_t n = ::pread(file->fd, buffer + total, size - total, total);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) break; // 文件在stat之后被截短时只保留实际读到的部分
+            total += n;
+        }
+        return total;
+    }
+    
+    // 只读映射整个文件，映射由返回的storage持有
+    // 映射层假设文件以重命名方式原子替换；原地截短正在发送的文件会导致SIGBUS
+    std::pair<std::string_view, std::shared_ptr<const void>> mapFile(const std::string& relativePath, size_t size,
+                                                                     uint64_t generation) {
+        auto file = openFile(relativePath, generation);
+        if (static_cast<size_t>(file->st.st_size) < size) {
+            throw std::runtime_error("File changed while mapping");
+        }
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file->fd, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map file");
+        }
+        ::madvise(mapped, size, MADV_WILLNEED);
+        std::shared_ptr<const void> storage(mapped, [size](const void* p) {
+            ::munmap(const_cast<void*>(p), size);
+        });
+        return {std::string_view(static_cast<const char*>(mapped), size), std::move(storage)};
+    }
+    
+    // 打开大文件用于流式发送，内容由sendfile直接从文件发送
+    // fd来自文件描述符缓存，热门下载无需每次open/fstat/close；头部按fd的fstat快照生成
+    FileResponse openLargeFile(const std::string& relativePath, const FileMetadata& metadata, uint64_t generation) {
+        auto file = acquireOpenFile(relativePath, generation);
+        if (!file) {
+            return {500, "", ""};
+        }
+        size_t size = file->st.st_size;
+        auto response = std::make_shared<CachedResponse>();
+        response->statusCode = 200;
+        response->mimeType = metadata.mimeType;
+        response->headerBlock = ResponseCache::buildHeaderBlock(200, metadata.mimeType, size,
+                                    ResponseCache::buildValidators(size, file->st.st_mtime));
+        response->storage = file;
+        
+        FileResponse result(std::shared_ptr<const CachedResponse>(std::move(response)));
+        result.fileFd = file->fd;
+        result.fileSize = size;
+        streamedFiles.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+    
+    // 由元数据生成只含头部的HEAD响应
+    std::shared_ptr<const CachedResponse> buildHeadResponse(const FileMetadata& metadata) {
+        auto response = std::make_shared<CachedResponse>();
+        response->statusCode = 200;
+        response->mimeType = metadata.mimeType;
+        response->headerBlock = ResponseCache::buildHeaderBlock(200, metadata.mimeType, metadata.size,
+                                    ResponseCache::buildValidators(metadata.size, metadata.mtime));
+        return response;
     }
     
     // 尝试找到默认文件
@@ -197,99 +559,35 @@ private:
     }
     
     // 高效读取文件
-    std::string readFile(const std::string& fullPath, uintmax_t fileSize) {
-        std::ifstream file(fullPath, std::ios::binary | std::ios::ate);
-        if (!file) {
-            throw std::runtime_error("Cannot open file");
-        }
-        
+    std::string readFile(const std::string& relativePath, uintmax_t fileSize, uint64_t generation) {
         std::string content;
         content.resize(fileSize);
         
-        // 将文件指针移动到开头并一次性读取文件
-        file.seekg(0, std::ios::beg);
-        file.read(&content[0], fileSize);
+        // 一次性读取文件，文件在stat之后被截短时只保留实际读到的部分
+        content.resize(readInto(relativePath, content.data(), fileSize, generation));
         
         return content;
     }
     
-    // 读取大文件（不缓存）
-    std::pair<std::string, std::string> readLargeFile(const std::string& fullPath) {
-        std::ifstream file(fullPath, std::ios::binary);
-        if (!file) {
-            return {"500", ""};
-        }
-        
-        std::string content;
-        constexpr size_t bufferSize = 8192;
-        char buffer[bufferSize];
-        
-        while (file) {
-            file.read(buffer, bufferSize);
-            content.append(buffer, file.gcount());
-        }
-        
-        return {"200", content};
-    }
-    
-    // 从缓存获取文件内容
-    std::optional<std::reference_wrapper<const CacheEntry>> getCachedContent(const std::string& path) {
-        std::lock_guard<std::mutex> lock(cacheMutex);
-        auto it = fileCache.find(path);
-        if (it != fileCache.end()) {
-            it->second.updateLastAccess();
-            return std::cref(it->second);
-        }
-        return std::nullopt;
-    }
-    
-    // 缓存文件
-    void cacheFile(const std::string& path, const std::string& content, const std::string& mimeType) {
-        std::lock_guard<std::mutex> lock(cacheMutex);
-        
-        // 检查是否需要进行缓存管理
-        if (fileCache.size() >= maxCacheEntries || currentCacheSize + content.size() > maxCacheSize) {
-            evictCache(content.size());
-        }
-        
-        // 添加到缓存
-        auto [it, success] = fileCache.emplace(path, CacheEntry(content, mimeType));
-        if (success) {
-            currentCacheSize += content.size();
+    // 从缓存获取文件内容，返回的条目由引用计数保持有效
+    // 小文件请求远多于大文件，先查小文件层
+    std::shared_ptr<const CachedResponse> getCachedContent(std::string_view path) {
+        if (auto cached = smallCache.lookup(path)) {
+            return cached;
         }
+        return mappedCache.lookup(path);
     }
     
-    // 删除最久未访问的缓存项
-    void evictCache(size_t requiredSpace) {
-        if (fileCache.empty()) return;
-        
-        // 按最后访问时间排序
-        std::vector<std::pair<std::string, std::reference_wrapper<CacheEntry>>> entries;
-        entries.reserve(fileCache.size());
-        
-        for (auto& entry : fileCache) {
-            entries.emplace_back(entry.first, std::ref(entry.second));
+    // 按大小放入对应的缓存层，是否真正缓存由准入策略决定；加载期间文件发生过变化时不缓存
+    bool cacheFile(const std::string& path, const std::shared_ptr<const CachedResponse>& response, uint64_t generation) {
+        std::lock_guard<std::mutex> lock(generationMutex);
+        if (generationSlot(path) != generation) {
+            return false;
         }
-        
-        // 按最后访问时间排序（从旧到新）
-        std::sort(entries.begin(), entries.end(), 
-            [](const auto& a, const auto& b) {
-                return a.second.get().lastAccess < b.second.get().lastAccess;
-            });
-        
-        // 删除足够的缓存项
-        size_t freedSpace = 0;
-        auto it = entries.begin();
-        while (freedSpace < requiredSpace && it != entries.end()) {
-            const auto& key = it->first;
-            const auto& entry = it->second.get();
-            
-            freedSpace += entry.size;
-            currentCacheSize -= entry.size;
-            fileCache.erase(key);
-            
-            ++it;
+        if (response->body.size() > maxSmallFileSize) {
+            return mappedCache.insert(path, response);
         }
+        return smallCache.insert(path, response);
     }
 
     // 初始化MIME类型映射
@@ -398,108 +696,82 @@ private:
         return sanitized;
     }
 
-    // 生成目录列表HTML
-    std::string generateDirectoryListing(const std::string& dirPath, const std::string& requestPath) {
-        std::ostringstream html;
-        html << "<!DOCTYPE html>\n";
-        html << "<html>\n<head>\n";
-        html << "<meta charset=\"UTF-8\">\n";
-        html << "<title>目录列表: " << requestPath << "</title>\n";
-        html << "<style>\n";
-        html << "body { font-family: Arial, sans-serif; margin: 20px; }\n";
-        html << "h1 { color: #333; }\n";
-        html << "ul { list-style-type: none; padding: 0; }\n";
-        html << "li { margin: 5px 0; }\n";
-        html << "a { text-decoration: none; color: #0066cc; }\n";
-        html << "a:hover { text-decoration: underline; }\n";
-        html << ".directory { font-weight: bold; }\n";
-        html << "</style>\n";
-        html << "</head>\n<body>\n";
-        html << "<h1>目录: " << requestPath << "</h1>\n";
-        html << "<ul>\n";
-        
-        // 添加返回上级目录的链接
-        if (requestPath != "/" && requestPath != "") {
-            // 确保路径以/结尾
-            std::string normalizedPath = requestPath;
-            if (!normalizedPath.empty() && normalizedPath.back() != '/') {
-                normalizedPath += '/';
-            }
-            
-            // 移除最后一个/
-            if (normalizedPath.length() > 1) {
-                normalizedPath.pop_back();
-            }
-            
-            // 查找倒数第二个/
-            size_t pos = normalizedPath.find_last_of('/');
-            std::string parentDir = "/";
-            
-            if (pos != std::string::npos) {
-                // 确保最终路径以/结尾
-                parentDir = normalizedPath.substr(0, pos + 1);
-                if (parentDir.empty()) {
-                    parentDir = "/";
-                }
-            }
-            
-            html << "<li><a href=\"" << parentDir << "\">..</a> (上级目录)</li>\n";
-            LOG_DEBUG(fmt::format("生成目录列表，当前路径：{}，父目录：{}", requestPath, parentDir));
+    // 读取目录快照并放入目录列表缓存，打开失败返回nullptr
+    std::shared_ptr<const DirectoryListing> loadDirectoryListing(const std::string& path, uint64_t generation) {
+        int fd = root.openBeneath(path, O_RDONLY | O_DIRECTORY);
+        if (fd == -1) {
+            LOG_ERROR("无法打开目录 {}: {}", path, strerror(errno));
+            return nullptr;
         }
-        
-        // 列出所有文件和目录
-        try {
-            std::vector<fs::directory_entry> entries;
-            for (const auto& entry : fs::directory_iterator(dirPath)) {
-                entries.push_back(entry);
-            }
-            
-            // 先排序：目录在前，文件在后，按名称字母顺序排序
-            std::sort(entries.begin(), entries.end(), [](const fs::directory_entry& a, const fs::directory_entry& b) {
-                if (fs::is_directory(a) && !fs::is_directory(b)) return true;
-                if (!fs::is_directory(a) && fs::is_directory(b)) return false;
-                return a.path().filename().string() < b.path().filename().string();
-            });
-            
-            for (const auto& entry : entries) {
-                std::string name = entry.path().filename().string();
-                std::string url = requestPath;
-                if (url.back() != '/') url += '/';
-                url += name;
-                
-                if (fs::is_directory(entry)) {
-                    html << "<li><a class=\"directory\" href=\"" << url << "/\">" 
-                         << name << "/</a></li>\n";
-                } else {
-                    // 对于文件，显示其大小
-                    auto fileSize = fs::file_size(entry);
-                    std::string sizeStr;
-                    
-                    if (fileSize < 1024) {
-                        sizeStr = fmt::format("{} B", fileSize);
-                    } else if (fileSize < 1024 * 1024) {
-                        sizeStr = fmt::format("{:.1f} KB", fileSize / 1024.0);
-                    } else if (fileSize < 1024 * 1024 * 1024) {
-                        sizeStr = fmt::format("{:.1f} MB", fileSize / (1024.0 * 1024));
-                    } else {
-                        sizeStr = fmt::format("{:.1f} GB", fileSize / (1024.0 * 1024 * 1024));
-                    }
-                    
-                    html << "<li><a href=\"" << url << "\">" 
-                         << name << "</a> (" << sizeStr << ")</li>\n";
-                }
-            }
-        } catch (const std::exception& e) {
-            LOG_ERROR(fmt::format("生成目录列表时发生错误: {}", e.what()));
-            html << "<li>读取目录内容时发生错误</li>\n";
+        auto listing = DirectoryListing::read(fd);
+        std::lock_guard<std::mutex> lock(generationMutex);
+        if (listing && generationSlot(path) == generation) {
+            listingCache.insert(path, listing);
         }
-        
-        html << "</ul>\n";
-        html << "<hr>\n";
-        html << "<p>C++20 HTTP Server</p>\n";
-        html << "</body>\n</html>";
-        
-        return html.str();
+        return listing;
+    }
+    
+    // 通过文件描述符缓存打开文件，新打开的fd只在代数未变化时放入缓存；打开失败返回nullptr
+    std::shared_ptr<const OpenFile> acquireOpenFile(const std::string& relativePath, uint64_t generation) {
+        if (auto file = openFileCache.lookup(relativePath)) {
+            return file;
+        }
+        int fd = root.openBeneath(relativePath, O_RDONLY | O_NONBLOCK);
+        if (fd == -1) {
+            return nullptr;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return nullptr;
+        }
+        return storeOpenFile(relativePath, fd, st, generation);
+    }
+    
+    std::shared_ptr<const OpenFile> storeOpenFile(const std::string& relativePath, int fd, const struct stat& st,
+                                                  uint64_t generation) {
+        std::lock_guard<std::mutex> lock(generationMutex);
+        if (generationSlot(relativePath) != generation) {
+            return openFileCache.wrap(fd, st);
+        }
+        return openFileCache.store(relativePath, fd, st);
+    }
+    
+    // 缓存代数：后台加载（加载线程、缓存预热）在读取文件之前记下路径所在槽的代数，
+    // 写入各缓存前在generationMutex下比较；文件变化时先在同一把锁下递增代数再使缓存失效，
+    // 因此读到旧内容的加载要么在失效之前写入（随后被清除），要么发现代数变化而放弃写入
+    // 路径按散列分到固定数量的槽，同槽的其他路径变化只会让加载多放弃一次缓存写入
+    static constexpr size_t GENERATION_SLOTS = 64;
+    
+    uint64_t currentGeneration(const std::string& relativePath) {
+        std::lock_guard<std::mutex> lock(generationMutex);
+        return generationSlot(relativePath);
+    }
+    
+    // 文件本身和所在目录（目录列表包含该文件）的槽都要递增
+    void bumpGeneration(const std::string& relativePath) {
+        std::lock_guard<std::mutex> lock(generationMutex);
+        generationSlot(relativePath)++;
+        generationSlot(parentOf(relativePath))++;
+    }
+    
+    // 目录变化影响其下所有路径，递增全部槽
+    void bumpAllGenerations() {
+        std::lock_guard<std::mutex> lock(generationMutex);
+        for (auto& generation : generations) {
+            generation++;
+        }
+    }
+    
+    // 调用方持有generationMutex
+    uint64_t& generationSlot(std::string_view relativePath) {
+        return generations[std::hash<std::string_view>{}(relativePath) % GENERATION_SLOTS];
+    }
+    
+    // 相对路径的上级目录，根目录下的条目返回空字符串
+    static std::string parentOf(const std::string& relativePath) {
+        size_t pos = relativePath.find_last_of('/');
+        return pos == std::string::npos ? "" : relativePath.substr(0, pos);
     }
 
     std::string rootDirectory;
@@ -507,10 +779,20 @@ private:
     std::vector<std::string> defaultFiles;
     
     // 文件缓存相关
-    std::unordered_map<std::string, CacheEntry> fileCache;
-    std::mutex cacheMutex;
-    size_t currentCacheSize{0};
-    size_t maxCacheSize{100 * 1024 * 1024}; // 默认100MB
+    std::shared_ptr<SlabArena> arena;
+    FileCache smallCache;   // 小文件层，内容在内存池中
+    FileCache mappedCache;  // 中等文件层，内容为只读文件映射
+    OpenFileCache openFileCache;
+    RootDirectory root;
+    std::shared_ptr<const ContentPack> contentPack;
+    MetadataCache metadataCache;
+    DirectoryListingCache listingCache;
+    size_t maxCacheSize{100 * 1024 * 1024}; // 小文件层容量，默认100MB
     size_t maxCacheEntries{1000};
-    size_t maxCacheFileSize{5 * 1024 * 1024}; // 默认最大文件5MB
+    size_t maxSmallFileSize{64 * 1024}; // 默认64KB以下为小文件
+    size_t maxMappedCacheSize{1024 * 1024 * 1024}; // 映射层容量，默认1GB
+    size_t maxCacheFileSize{64 * 1024 * 1024}; // 默认64MB以上的文件流式发送
+    std::atomic<size_t> streamedFiles{0};
+    std::mutex generationMutex;
+    std::array<uint64_t, GENERATION_SLOTS> generations{};
 };
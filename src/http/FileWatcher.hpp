@@ -0,0 +1,180 @@
+#pragma once
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <fmt/format.h>
+#include "FileLoader.hpp"
+#include "FileService.hpp"
+#include "../core/Logger.hpp"
+
+namespace fs = std::filesystem;
+
+// 基于inotify的根目录监视器，集成到事件循环中
+// 文件变化时只失效或刷新受影响的缓存项，无需每个请求都stat()重新验证
+class FileWatcher {
+public:
+    static FileWatcher& getInstance() {
+        static FileWatcher instance;
+        return instance;
+    }
+
+    // 初始化inotify并递归监视根目录
+    bool init(const std::string& rootDir) {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd == -1) {
+            LOG_ERROR("inotify初始化失败: {}", strerror(errno));
+            return false;
+        }
+        rootDirectory = rootDir;
+        addWatchRecursive("");
+        LOG_INFO("文件监视已启动，监视目录数: {}", watches.size());
+        return true;
+    }
+
+    int getFd() const {
+        return inotifyFd;
+    }
+
+    // 读取并处理所有待处理的事件，直到EAGAIN
+    void processEvents() {
+        alignas(struct inotify_event) char buffer[16 * 1024];
+        while (true) {
+            ssize_t len = ::read(inotifyFd, buffer, sizeof(buffer));
+            if (len == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    LOG_ERROR("读取inotify事件失败: {}", strerror(errno));
+                }
+                return;
+            }
+            if (len == 0) return;
+
+            for (char* p = buffer; p < buffer + len;) {
+                const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+                handleEvent(*event);
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+
+    ~FileWatcher() {
+        if (inotifyFd != -1) {
+            ::close(inotifyFd);
+        }
+    }
+
+private:
+    FileWatcher() = default;
+
+    // 删除复制和移动构造/赋值
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    FileWatcher(FileWatcher&&) = delete;
+    FileWatcher& operator=(FileWatcher&&) = delete;
+
+    static constexpr uint32_t WATCH_MASK =
+        IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+    static std::string joinRelative(const std::string& dir, const std::string& name) {
+        return dir.empty() ? name : dir + "/" + name;
+    }
+
+    // 监视目录及其所有子目录
+    void addWatchRecursive(const std::string& relativeDir) {
+        std::string fullDir = relativeDir.empty() ? rootDirectory : rootDirectory + "/" + relativeDir;
+        int wd = inotify_add_watch(inotifyFd, fullDir.c_str(), WATCH_MASK | IN_ONLYDIR);
+        if (wd == -1) {
+            LOG_WARNING("无法监视目录 {}: {}", fullDir, strerror(errno));
+            return;
+        }
+        watches[wd] = relativeDir;
+
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(fullDir, ec)) {
+            if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+                addWatchRecursive(joinRelative(relativeDir, entry.path().filename().string()));
+            }
+        }
+    }
+
+    // 停止监视目录及其所有子目录
+    void removeWatchTree(const std::string& relativeDir) {
+        std::string prefix = relativeDir + "/";
+        for (auto it = watches.begin(); it != watches.end();) {
+            if (it->second == relativeDir || it->second.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(inotifyFd, it->first);
+                it = watches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void handleEvent(const struct inotify_event& event) {
+        auto& fileService = FileService::getInstance();
+
+        if (event.mask & IN_Q_OVERFLOW) {
+            // 丢失了事件，无法确定哪些文件变化，只能整体清空
+            LOG_WARNING("inotify事件队列溢出，清空文件缓存");
+            fileService.clearCache();
+            return;
+        }
+        if (event.mask & IN_IGNORED) {
+            watches.erase(event.wd);
+            return;
+        }
+
+        auto it = watches.find(event.wd);
+        if (it == watches.end() || event.len == 0) {
+            return;
+        }
+        std::string relativePath = joinRelative(it->second, event.name);
+
+        if (event.mask & IN_ISDIR) {
+            if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+                removeWatchTree(relativePath);
+                fileService.onDirectoryChanged(relativePath);
+            } else if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+                addWatchRecursive(relativePath);
+                fileService.onDirectoryChanged(relativePath);
+            }
+            return;
+        }
+
+        // 任何变化都先失效；写入完成或原子替换(rename)时，
+        // 若该文件此前在缓存中（包括写入过程中被失效的），则在后台重新加载
+        bool wasCached = fileService.invalidateFile(relativePath);
+        if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            if (pendingRefresh.erase(relativePath) > 0 || wasCached) {
+                refreshFile(relativePath);
+            }
+        } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            pendingRefresh.erase(relativePath);
+        } else if (wasCached) {
+            pendingRefresh.insert(relativePath);
+        }
+    }
+
+    // 重新加载交给文件加载线程，大量文件同时更新时事件循环只做失效，不阻塞在磁盘读取上
+    // 未启用文件加载器时和缓存未命中一样在事件循环中同步加载
+    void refreshFile(const std::string& relativePath) {
+        std::string path = "/" + relativePath;
+        auto& loader = FileLoader::getInstance();
+        if (loader.isEnabled()) {
+            loader.reload(path);
+        } else {
+            FileService::getInstance().loadFileContent(path);
+        }
+        LOG_DEBUG("文件重新加载: {}", relativePath);
+    }
+
+    int inotifyFd{-1};
+    std::string rootDirectory;
+    std::unordered_map<int, std::string> watches; // wd -> 相对根目录的路径
+    std::unordered_set<std::string> pendingRefresh; // 写入中被失效、等待写入完成后刷新的文件
+};
@@ -1,37 +1,36 @@
 #pragma once
 #include "RequestParser.hpp"
+#include "UrlDecoder.hpp"
+#include "ResponseHeaders.hpp"
 #include "../core/Logger.hpp"
+#include "../utils/PerformanceMonitor.hpp"
+#include "../utils/RequestTimeline.hpp"
+#include "../utils/ConnectionStats.hpp"
 #include <cstddef>
 #include <cstring>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unistd.h>
-#include <unordered_map>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <iterator>
+#include <utility>
 #include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
 #include <cerrno>
 #include <coroutine>
 #include <sys/epoll.h>
 #include <vector>
+#include <fmt/format.h>
 
-// HTTP状态码和描述映射
-const std::unordered_map<std::string, std::string> HTTP_STATUS_CODES = {
-    {"200", "OK"},
-    {"201", "Created"},
-    {"204", "No Content"},
-    {"301", "Moved Permanently"},
-    {"302", "Found"},
-    {"304", "Not Modified"},
-    {"400", "Bad Request"},
-    {"401", "Unauthorized"},
-    {"403", "Forbidden"},
-    {"404", "Not Found"},
-    {"405", "Method Not Allowed"},
-    {"500", "Internal Server Error"},
-    {"501", "Not Implemented"},
-    {"502", "Bad Gateway"},
-    {"503", "Service Unavailable"}
-};
+// 每个请求补在预序列化头部块之后的Connection头（含结尾空行）
+inline constexpr std::string_view KEEP_ALIVE_HEADERS = "Connection: keep-alive\r\nKeep-Alive: timeout=5, max=100\r\n\r\n";
+inline constexpr std::string_view CLOSE_HEADERS = "Connection: close\r\n\r\n";
 
 class HttpServer {
 public:
@@ -41,61 +40,74 @@ public:
     class HttpRequest {
     private:
         RequestParser parser;
-        std::unordered_map<std::string, std::string> queryParams;
-        
-        void parseQueryParams() {
-            std::string url = parser.getUrl();
-            size_t pos = url.find('?');
-            if (pos != std::string::npos) {
-                std::string query = url.substr(pos + 1);
-                std::string path = url.substr(0, pos);
-                
-                size_t start = 0;
-                size_t end;
-                while ((end = query.find('&', start)) != std::string::npos) {
-                    parseQueryParam(query.substr(start, end - start));
-                    start = end + 1;
-                }
-                parseQueryParam(query.substr(start));
-            }
-        }
-
-        void parseQueryParam(const std::string& param) {
-            size_t pos = param.find('=');
-            if (pos != std::string::npos) {
-                std::string key = param.substr(0, pos);
-                std::string value = param.substr(pos + 1);
-                queryParams[key] = value;
+        
+        // 路径和查询参数在首次访问时才解码，结果为指向URL或暂存区的视图
+        mutable ScratchArena scratch;
+        mutable QueryParams queryParams;
+        mutable std::string_view decodedPath;
+        mutable bool pathDecoded = false;
+        mutable bool paramsParsed = false;
+        
+        RequestTimeline* timeline = nullptr; // 启用性能监控或访问日志时由连接设置，记录收到第一个字节、解析完成的时间和读取的字节数
+        
+        // 解码结果总长度不超过URL长度，首次解码前一次性预留，之后的视图都不会失效
+        void prepareScratch() const {
+            if (scratch.empty()) {
+                scratch.reset(parser.getUrl().size());
             }
         }
-
+        
     public:
-        HttpRequest() = default;
+        explicit HttpRequest(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : parser(memory) {}
         ~HttpRequest() = default;
         bool readComplete = false;
+        ConnectionStats* stats = nullptr; // 启用连接统计时由连接设置，记录读调用、读取的字节和等待可读的时间
+        
+        void setTimeline(RequestTimeline* timeline) {
+            this->timeline = timeline;
+        }
+        
+        void setStats(ConnectionStats* stats) {
+            this->stats = stats;
+        }
         
         void reset() {
             parser.reset();
+            scratch.reset();
             queryParams.clear();
+            decodedPath = {};
+            pathDecoded = false;
+            paramsParsed = false;
             readComplete = false;
         }
         
         // 读取方法，返回是否读取完成
-        bool read(int fd, std::vector<char>& buffer) {
+        bool read(int fd, char* buffer, size_t size) {
             if (readComplete) {
                 return true;
             }
             
-            ssize_t bytesRead = ::read(fd, buffer.data(), buffer.size());
+            ssize_t bytesRead = ::read(fd, buffer, size);
+            if (stats) {
+                stats->recordRead(bytesRead);
+            }
             
             if (bytesRead > 0) {
+                PerformanceMonitor::getInstance().recordBytesIn(bytesRead);
+                if (timeline) {
+                    timeline->markReceived(bytesRead);
+                }
                 // 解析请求
-                parseRequest(std::string_view(buffer.data(), bytesRead));
+                parseRequest(std::string_view(buffer, bytesRead));
                 
                 // 如果请求解析完成
                 if (isComplete()) {
                     readComplete = true;
-                    LOG_INFO(fmt::format("完成解析HTTP请求: {} {}", method(), path()));
+                    if (timeline) {
+                        timeline->markHeadersParsed();
+                    }
+                    LOG_INFO("完成解析HTTP请求: {} {}", method(), path());
                     return true;
                 }
                 
@@ -117,88 +129,179 @@ public:
         }
         void parseRequest(std::string_view request) {
             parser.parse(request);
-            if (parser.isComplete()) {
-                parseQueryParams();
-            }
         }
         
         bool isComplete() const {
             return parser.isComplete();
         }
         
-        std::string method() const {
+        std::string_view method() const {
             return parser.getMethod();
         }
         
-        std::string url() const {
+        std::string_view url() const {
             return parser.getUrl();
         }
         
-        std::string path() const {
-            return parser.getPath();
+        // 百分号解码后的路径
+        std::string_view path() const {
+            if (!pathDecoded) {
+                prepareScratch();
+                decodedPath = UrlDecoder::decode(parser.getPath(), scratch, false);
+                pathDecoded = true;
+            }
+            return decodedPath;
         }
         
-        std::string version() const {
+        std::string_view version() const {
             return parser.getHttpVersion();
         }
         
-        std::string getHeader(const std::string& key) const {
+        std::string_view getHeader(std::string_view key) const {
             return parser.getHeader(key);
         }
         
-        const std::unordered_map<std::string, std::string>& headers() const {
+        const RequestParser::HeaderList& headers() const {
             return parser.getHeaders();
         }
         
-        std::string body() const {
+        std::string_view body() const {
             return parser.getBody();
         }
         
-        std::string getParam(const std::string& key) const {
-            auto it = queryParams.find(key);
-            return (it != queryParams.end()) ? it->second : "";
+        // 解码后的查询参数，不存在时返回空视图
+        std::string_view getParam(std::string_view key) const {
+            return params().get(key);
         }
         
-        const std::unordered_map<std::string, std::string>& params() const {
+        const QueryParams& params() const {
+            if (!paramsParsed) {
+                std::string_view url = parser.getUrl();
+                size_t pos = url.find('?');
+                if (pos != std::string_view::npos) {
+                    prepareScratch();
+                    queryParams.parse(url.substr(pos + 1), scratch);
+                }
+                paramsParsed = true;
+            }
             return queryParams;
         }
     };
     
+    // 头部名称和值复制到构造时传入的内存池（连接级的RequestArena），随内存池整体释放，头部表本身容量固定
+    // 序列化时状态行取自预渲染的状态行表，Date头取自每秒更新一次的缓存，直接写入输出缓冲区
     class HttpResponse {
     public:
-        std::string version;
-        std::string statusCode;
-        std::string statusMessage;
-        std::unordered_map<std::string, std::string> headers;
-        std::string responseBody;
+        using String = std::pmr::string;
+        static constexpr size_t MAX_HEADERS = 16;
+        static constexpr std::string_view SERVER_HEADER = "Server: C++ HttpServer\r\n";
+        static constexpr std::string_view DEFAULT_CONTENT_TYPE = "text/html; charset=UTF-8";
+        
+        int status = 200;
+        FixedHeaderList<MAX_HEADERS> headers;
+        std::optional<size_t> contentLength;
+        String responseBody;
         
         // 添加写入状态追踪
-        std::string responseText;
+        String responseText;
         size_t bytesSent = 0;
         bool writePending = false;
         
+        // 预序列化响应（由缓存持有），发送时只补上Date头和Connection头
+        std::string_view prebuiltHeader;
+        std::string_view prebuiltBody;
+        std::shared_ptr<const void> prebuiltOwner;
+        bool keepAlive = true;
+        // 发送期间可能跨秒，Date头复制一份，不直接引用每秒更新的缓存
+        char dateHeader[HttpDate::HEADER_LENGTH];
+        
+        // 待发送的分段，由一次sendmsg批量发送
+        std::array<std::string_view, 4> segments;
+        size_t segmentCount = 0;
+        size_t segmentsSize = 0;
+        size_t totalSize = 0;
+        
+        // 流式发送的文件内容（大文件），分段发送完后用sendfile直接从文件发送
+        int fileFd = -1;
+        size_t fileSize = 0;
+        
+        // 分块传输编码：头部发送后，由调用方逐块填充并发送响应体
+        bool chunked = false;
+        
+        // 启用性能监控时由连接设置，记录首字节和末字节的发送时间
+        RequestTimeline* timeline = nullptr;
+        // 启用连接统计时由连接设置，记录写调用、发送的字节和等待可写的时间
+        ConnectionStats* stats = nullptr;
+        
+    private:
+        std::pmr::memory_resource* memory;
+        
+        // 把头部名称或值复制到内存池，调用方传入的视图不必在发送前保持有效
+        std::string_view store(std::string_view text) {
+            if (text.empty()) {
+                return {};
+            }
+            char* copy = static_cast<char*>(memory->allocate(text.size(), 1));
+            std::memcpy(copy, text.data(), text.size());
+            return std::string_view(copy, text.size());
+        }
+        
     public:
-        HttpResponse() : version("HTTP/1.1"), statusCode("200"), statusMessage("OK") {
-            headers["Server"] = "C++ HttpServer";
-            headers["Content-Type"] = "text/html; charset=UTF-8";
-            // headers["Connection"] = "keep-alive";
+        explicit HttpResponse(std::pmr::memory_resource* memory)
+            : responseBody(memory), responseText(memory), memory(memory) {
+            headers.set("Content-Type", DEFAULT_CONTENT_TYPE);
         }
+        // 字符串换成全新的空容器：clear()会保留指向内存池的容量，内存池随后会被整体重置
         void reset(){
-            version = "HTTP/1.1";
-            statusCode = "200";
-            statusMessage = "OK";
+            status = 200;
             headers.clear();
-            responseBody.clear();
-            responseText.clear();
+            headers.set("Content-Type", DEFAULT_CONTENT_TYPE);
+            contentLength.reset();
+            responseBody = String(memory);
+            responseText = String(memory);
+            prebuiltHeader = {};
+            prebuiltBody = {};
+            prebuiltOwner.reset();
+            keepAlive = true;
+            segmentCount = 0;
+            segmentsSize = 0;
+            totalSize = 0;
+            fileFd = -1;
+            fileSize = 0;
+            chunked = false;
             bytesSent = 0;
             writePending = false;
         }
+        void setTimeline(RequestTimeline* timeline) {
+            this->timeline = timeline;
+        }
+        
+        void setStats(ConnectionStats* stats) {
+            this->stats = stats;
+        }
+        
         bool isWritePending() const {
             return writePending;
         }
         // 初始化响应文本
         void init(){
-            responseText = toString();
+            if (prebuiltOwner) {
+                // 预序列化响应：头部块 + Date头 + Connection头 + 响应体
+                std::string_view date = HttpDate::currentHeader();
+                std::memcpy(dateHeader, date.data(), date.size());
+                segments = {prebuiltHeader, std::string_view(dateHeader, date.size()),
+                            keepAlive ? KEEP_ALIVE_HEADERS : CLOSE_HEADERS, prebuiltBody};
+                segmentCount = 4;
+            } else {
+                serialize();
+                segments[0] = responseText;
+                segmentCount = 1;
+            }
+            segmentsSize = 0;
+            for (size_t i = 0; i < segmentCount; ++i) {
+                segmentsSize += segments[i].size();
+            }
+            totalSize = segmentsSize + (fileFd != -1 ? fileSize : 0);
             bytesSent = 0;
             writePending = true;
         }
@@ -210,52 +313,108 @@ public:
         
         // 查询写入是否完成
         bool isWriteComplete() const {
-            return !writePending || bytesSent >= responseText.size();
+            return !writePending || bytesSent >= totalSize;
+        }
+        
+        // 设置连接是否保持，Connection头在序列化时补上
+        void setKeepAlive(bool enable) {
+            keepAlive = enable;
         }
         
-        void setStatus(const std::string_view code, const std::string_view message) {
-            statusCode = code;
-            statusMessage = message;
+        // 使用预序列化的头部块和响应体，owner负责保持两者的生命周期
+        void setPrebuilt(std::string_view header, std::string_view body, std::shared_ptr<const void> owner) {
+            prebuiltHeader = header;
+            prebuiltBody = body;
+            prebuiltOwner = std::move(owner);
         }
         
-        void setHeader(const std::string& key, const std::string& value) {
-            headers[key] = value;
+        // 在预序列化头部之后流式发送文件内容，fd的生命周期由setPrebuilt的owner负责
+        void setFileBody(int fd, size_t size) {
+            fileFd = fd;
+            fileSize = size;
         }
         
-        void setBody(const std::string& body) {
-            responseBody = body;
-            headers["Content-Length"] = std::to_string(responseBody.length());
+        // 使用分块传输编码，响应体长度事先未知
+        void setChunked() {
+            chunked = true;
+            contentLength.reset();
+            setHeader("Transfer-Encoding", "chunked");
         }
         
-        void setContentType(const std::string& contentType) {
-            headers["Content-Type"] = contentType;
+        bool isChunked() const {
+            return chunked;
+        }
+        
+        // 准备发送下一个分块，last为true时在其后追加结束块；之后再次co_await HttpResponseAwaiter发送
+        void setChunk(std::string_view data, bool last) {
+            responseText.clear();
+            if (!data.empty()) {
+                fmt::format_to(std::back_inserter(responseText), "{:x}\r\n", data.size());
+                responseText.append(data).append("\r\n");
+            }
+            if (last) {
+                responseText.append("0\r\n\r\n");
+            }
+            segments[0] = responseText;
+            segmentCount = 1;
+            segmentsSize = totalSize = responseText.size();
+            bytesSent = 0;
+            writePending = true;
+        }
+        
+        void setStatus(int code) {
+            status = code;
+        }
+        
+        int getStatus() const {
+            return status;
+        }
+        
+        // 已存在的头部被替换；超过MAX_HEADERS个时抛出异常
+        void setHeader(std::string_view key, std::string_view value) {
+            headers.set(store(key), store(value));
+        }
+        
+        void removeHeader(std::string_view key) {
+            headers.remove(key);
+        }
+        
+        void setBody(std::string_view body) {
+            responseBody.assign(body);
+            contentLength = responseBody.size();
+        }
+        
+        // 只设置Content-Length而不带响应体（HEAD请求）
+        void setContentLength(size_t length) {
+            contentLength = length;
+        }
+        
+        // HEAD请求：保留Content-Length等头部，去掉已设置的响应体
+        void omitBody() {
+            responseBody.clear();
+            prebuiltBody = {};
+            fileFd = -1;
+        }
+        
+        void setContentType(std::string_view contentType) {
+            setHeader("Content-Type", contentType);
         }
         int bodyLength() const {
             return responseBody.length();
         }
-        // 优化toString方法，减少内存分配
-        std::string toString() const {
-            // 预估响应大小
-            size_t estimatedSize = 
-                version.size() + statusCode.size() + statusMessage.size() + 
-                responseBody.size() + headers.size() * 30 + 20;
-            
-            std::string result;
-            result.reserve(estimatedSize);
-            
-            // 直接拼接字符串，避免stringstream开销
-            result.append(version).append(" ").append(statusCode).append(" ")
-                  .append(statusMessage).append("\r\n");
-            
-            // 添加headers
-            for (const auto& [key, value] : headers) {
-                result.append(key).append(": ").append(value).append("\r\n");
+        
+    private:
+        // 状态行、Date、Server、头部表、Content-Length、Connection头和响应体依次写入responseText
+        void serialize() {
+            responseText.clear();
+            responseText.reserve(256 + headers.size() * 32 + responseBody.size());
+            HttpStatus::append(responseText, status);
+            responseText.append(HttpDate::currentHeader()).append(SERVER_HEADER);
+            headers.appendTo(responseText);
+            if (contentLength) {
+                fmt::format_to(std::back_inserter(responseText), "Content-Length: {}\r\n", *contentLength);
             }
-            
-            // 空行和响应体
-            result.append("\r\n").append(responseBody);
-            
-            return result;
+            responseText.append(keepAlive ? KEEP_ALIVE_HEADERS : CLOSE_HEADERS).append(responseBody);
         }
     };
     class HttpRequestAwaiter {
@@ -263,18 +422,19 @@ public:
         HttpRequest& request;
         int clientFd;
         int epollFd;
-        std::vector<char>buffer;
+        std::array<char, 4096> buffer; // 位于协程帧中，读取时不再分配
     public:
         HttpRequestAwaiter(HttpRequest& req, int clientFd, int epollFd)
-            : request(req), clientFd(clientFd), epollFd(epollFd){
-                buffer.resize(1024); // 初始化缓冲区大小
-            }
+            : request(req), clientFd(clientFd), epollFd(epollFd) {}
         
         bool await_ready() {
-            return request.read(clientFd, buffer);
+            return request.read(clientFd, buffer.data(), buffer.size());
         }
         
         void await_suspend(std::coroutine_handle<> handle) {
+            if (request.stats) {
+                request.stats->beginWait();
+            }
             // 注册epoll事件
             struct epoll_event ev;
             ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
@@ -291,10 +451,13 @@ public:
         }
         
         void await_resume() {
+            if (request.stats) {
+                request.stats->endWait();
+            }
             // 继续处理请求
             while(!request.isComplete()) {
                 try {
-                    if (request.read(clientFd, buffer)) {
+                    if (request.read(clientFd, buffer.data(), buffer.size())) {
                         // 如果读取完成，退出循环
                         break;
                     }
@@ -312,12 +475,16 @@ public:
         HttpServer::HttpResponse& response;
         int clientFd;
         int epollFd;
+        bool wouldBlock = false; // 最近一次写入是否遇到EAGAIN
         
     public:
         HttpResponseAwaiter(HttpServer::HttpResponse& resp, int clientFd, int epollFd)
             : response(resp), clientFd(clientFd), epollFd(epollFd) {}
         
         bool await_ready() { 
+            if (response.stats) {
+                response.stats->setState(ConnectionStats::Writing);
+            }
             // 准备响应文本(如果尚未准备)
             if (!response.isWritePending()) {
                 response.init();
@@ -331,6 +498,13 @@ public:
         }
         
         void await_suspend(std::coroutine_handle<> handle) {
+            // 挂起期间不计入处理函数的CPU时间
+            if (response.timeline) {
+                response.timeline->pauseHandler();
+            }
+            if (response.stats) {
+                response.stats->beginWait();
+            }
             // 只有在需要等待时才注册epoll事件
             struct epoll_event ev;
             ev.events = EPOLLOUT | EPOLLET | EPOLLONESHOT;
@@ -346,9 +520,17 @@ public:
             }
         }
         
+        // 恢复后写到完成或再次EAGAIN为止；未写完时由调用方再次co_await
         void await_resume() {
+            if (response.timeline) {
+                response.timeline->resumeHandler();
+            }
+            if (response.stats) {
+                response.stats->endWait();
+            }
             //epoll事件触发后，继续尝试写入
-            while(!response.isWriteComplete()) {
+            wouldBlock = false;
+            while(!response.isWriteComplete() && !wouldBlock) {
                 try {
                     if (tryWrite()) {
                         // 如果写入完成，退出循环
@@ -366,19 +548,66 @@ public:
         // 尝试写入响应，返回是否完成
         bool tryWrite() {
             constexpr size_t MAX_WRITE_SIZE = 65536; // 64KB
-            size_t remaining = response.responseText.size() - response.bytesSent;
-            size_t toWrite = std::min(remaining, MAX_WRITE_SIZE);
             
-            // 使用send代替write，添加MSG_NOSIGNAL避免SIGPIPE
-            ssize_t sent = send(clientFd, 
-                                response.responseText.data() + response.bytesSent, 
-                                toWrite, 
-                                MSG_NOSIGNAL);
+            if (response.bytesSent >= response.segmentsSize && response.fileFd != -1) {
+                return trySendFile();
+            }
             
+            // 跳过已发送部分，把剩余分段组装为iovec
+            struct iovec iov[4];
+            int iovCount = 0;
+            size_t offset = response.bytesSent;
+            size_t budget = MAX_WRITE_SIZE;
+            for (size_t i = 0; i < response.segmentCount && budget > 0; ++i) {
+                std::string_view segment = response.segments[i];
+                if (offset >= segment.size()) {
+                    offset -= segment.size();
+                    continue;
+                }
+                size_t len = std::min(segment.size() - offset, budget);
+                iov[iovCount].iov_base = const_cast<char*>(segment.data() + offset);
+                iov[iovCount].iov_len = len;
+                ++iovCount;
+                budget -= len;
+                offset = 0;
+            }
+            
+            // 使用sendmsg一次发送所有分段，添加MSG_NOSIGNAL避免SIGPIPE
+            // 后面还有文件内容时加MSG_MORE，让头部和内容合并到同一个报文中
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iovCount;
+            ssize_t sent = sendmsg(clientFd, &msg, MSG_NOSIGNAL | (response.fileFd != -1 ? MSG_MORE : 0));
+            return handleSent(sent);
+        }
+        
+        // 用sendfile发送文件内容，数据不经过用户态
+        bool trySendFile() {
+            constexpr size_t MAX_SENDFILE_SIZE = 1024 * 1024; // 1MB
+            
+            off_t offset = response.bytesSent - response.segmentsSize;
+            size_t remaining = response.totalSize - response.bytesSent;
+            ssize_t sent = ::sendfile(clientFd, response.fileFd, &offset, std::min(remaining, MAX_SENDFILE_SIZE));
+            if (sent == 0) {
+                // 文件在发送过程中被截短，已发出的Content-Length无法兑现
+                throw std::runtime_error("文件在发送过程中被截短");
+            }
+            return handleSent(sent);
+        }
+        
+        // 处理一次写入的结果，返回是否全部发送完毕
+        bool handleSent(ssize_t sent) {
+            if (response.stats) {
+                response.stats->recordWrite(sent);
+            }
             if (sent > 0) {
+                PerformanceMonitor::getInstance().recordBytesOut(sent);
                 response.bytesSent += sent;
+                if (response.timeline) {
+                    response.timeline->markSent(sent, response.bytesSent >= response.totalSize);
+                }
                 // 检查是否全部发送完毕
-                if (response.bytesSent >= response.responseText.size()) {
+                if (response.bytesSent >= response.totalSize) {
                     response.writePending = false;
                     return true;
                 }
@@ -388,6 +617,7 @@ public:
             } else if (sent == -1) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     // 写缓冲区已满，需要等待
+                    wouldBlock = true;
                     return false;
                 } else if (errno == EPIPE || errno == ECONNRESET) {
                     // 连接已被客户端关闭
@@ -397,7 +627,7 @@ public:
                     throw std::runtime_error("write error: " + std::string(strerror(errno)));
                 }
             }
-        return true; // 写入完成
+            return false; // 部分写入，尚未完成
         }
     };
 };
@@ -0,0 +1,118 @@
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 文件元数据，包括"不存在"的负结果
+struct FileMetadata {
+    enum class Type { NotFound, Regular, Directory, Other };
+
+    Type type{Type::NotFound};
+    uintmax_t size{0};
+    std::time_t mtime{0};
+    std::string mimeType;
+    std::chrono::steady_clock::time_point expires;
+};
+
+// 以净化后的相对路径为键的元数据缓存
+// 命中时无需任何文件系统调用即可回答HEAD请求和404
+class MetadataCache {
+public:
+    void configure(std::chrono::seconds ttl, std::chrono::seconds negativeTtl, size_t maxEntries) {
+        std::unique_lock lock(mutex);
+        this->ttl = ttl;
+        this->negativeTtl = negativeTtl;
+        this->maxEntries = maxEntries;
+        entries.clear();
+    }
+
+    // 查找未过期的元数据，未命中或已过期返回nullptr
+    std::shared_ptr<const FileMetadata> lookup(std::string_view key) const {
+        std::shared_lock lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second->expires <= std::chrono::steady_clock::now()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    // 保存元数据并按类型设置过期时间
+    std::shared_ptr<const FileMetadata> store(const std::string& key, FileMetadata metadata) {
+        metadata.expires = std::chrono::steady_clock::now() +
+            (metadata.type == FileMetadata::Type::NotFound ? negativeTtl : ttl);
+        auto entry = std::make_shared<const FileMetadata>(std::move(metadata));
+
+        std::unique_lock lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second = entry;
+            return entry;
+        }
+        if (entries.size() >= maxEntries) {
+            purgeExpired();
+        }
+        // 仍然已满时不再插入，避免扫描器的大量随机路径冲掉有效条目
+        if (entries.size() < maxEntries) {
+            entries.emplace(key, entry);
+        }
+        return entry;
+    }
+
+    void invalidate(const std::string& key) {
+        std::unique_lock lock(mutex);
+        entries.erase(key);
+    }
+
+    // 使某个目录下的所有条目失效
+    void invalidatePrefix(std::string_view prefix) {
+        std::unique_lock lock(mutex);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (std::string_view(it->first).substr(0, prefix.size()) == prefix) {
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        std::unique_lock lock(mutex);
+        entries.clear();
+    }
+
+    size_t size() const {
+        std::shared_lock lock(mutex);
+        return entries.size();
+    }
+
+private:
+    // 支持以string_view查找，避免为查找构造临时字符串
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    void purgeExpired() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second->expires <= now) {
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const FileMetadata>, KeyHash, std::equal_to<>> entries;
+    std::chrono::seconds ttl{30};
+    std::chrono::seconds negativeTtl{5};
+    size_t maxEntries{10000};
+};
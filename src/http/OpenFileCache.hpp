@@ -0,0 +1,142 @@
+#pragma once
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 打开的文件及其fstat快照，最后一个引用释放时关闭fd
+// 被淘汰或失效后，正在发送中的响应仍可继续使用
+struct OpenFile {
+    int fd;
+    struct stat st;
+    std::chrono::steady_clock::time_point expires;
+
+    OpenFile(int fd, const struct stat& st, std::chrono::steady_clock::time_point expires)
+        : fd(fd), st(st), expires(expires) {}
+
+    ~OpenFile() {
+        ::close(fd);
+    }
+
+    OpenFile(const OpenFile&) = delete;
+    OpenFile& operator=(const OpenFile&) = delete;
+};
+
+// 打开文件描述符的LRU缓存（类似nginx的open_file_cache），以相对根目录的路径为键
+// 热门文件的重复请求无需open/fstat/close；条目在TTL后或文件变化时失效
+class OpenFileCache {
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t entries;
+    };
+
+    void configure(size_t maxEntries, std::chrono::seconds ttl) {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->maxEntries = maxEntries;
+        this->ttl = ttl;
+        lru.clear();
+        index.clear();
+    }
+
+    // 查找打开的文件，未缓存或已过期时返回nullptr，由调用方打开后store
+    std::shared_ptr<const OpenFile> lookup(const std::string& path) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(path);
+        if (it != index.end()) {
+            if (it->second->file->expires > now) {
+                lru.splice(lru.begin(), lru, it->second);
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return it->second->file;
+            }
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // 保存调用方已打开并fstat过的普通文件，fd的所有权转移给缓存
+    std::shared_ptr<const OpenFile> store(const std::string& path, int fd, const struct stat& st) {
+        auto file = wrap(fd, st);
+        if (maxEntries == 0) {
+            return file;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto it = index.find(path); it != index.end()) {
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        lru.push_front(Entry{path, file});
+        index.emplace(lru.front().path, lru.begin());
+        while (lru.size() > maxEntries) {
+            index.erase(lru.back().path);
+            lru.pop_back();
+        }
+        return file;
+    }
+
+    // 不放入缓存，只接管fd（文件在打开期间发生变化时使用）
+    std::shared_ptr<const OpenFile> wrap(int fd, const struct stat& st) const {
+        return std::make_shared<const OpenFile>(fd, st, std::chrono::steady_clock::now() + ttl);
+    }
+
+    void invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(path);
+        if (it != index.end()) {
+            lru.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    // 使某个目录下的所有条目失效
+    void invalidatePrefix(std::string_view prefix) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = lru.begin(); it != lru.end();) {
+            if (std::string_view(it->path).substr(0, prefix.size()) == prefix) {
+                index.erase(it->path);
+                it = lru.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        index.clear();
+        lru.clear();
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return Stats{hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed), lru.size()};
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        std::shared_ptr<const OpenFile> file;
+    };
+    using EntryList = std::list<Entry>;
+
+    mutable std::mutex mutex;
+    EntryList lru; // 最近使用的在前
+    std::unordered_map<std::string_view, EntryList::iterator> index; // 键指向条目内的path
+    size_t maxEntries{256};
+    std::chrono::seconds ttl{30};
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+};
@@ -1,25 +1,25 @@
 #pragma once
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <memory_resource>
+#include <utility>
 #include <vector>
 #include <algorithm>
+#include <charconv>
 
+// 所有解析结果都从构造时传入的内存池分配（通常是连接级的RequestArena）
 class RequestParser {
 public:
-    RequestParser() : contentLength(0), headerComplete(false), complete(false) {}
+    using String = std::pmr::string;
+    using HeaderList = std::pmr::vector<std::pair<String, String>>;
 
+    explicit RequestParser(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : buffer(memory), method(memory), url(memory), path(memory), httpVersion(memory),
+          headers(memory), bodyData(memory), contentLength(0), headerComplete(false), complete(false) {}
+
+    // 换成全新的空容器而不是clear()：clear()会保留指向内存池的容量，内存池随后会被整体重置
     void reset() {
-        buffer.clear();
-        method.clear();
-        url.clear();
-        path.clear();
-        httpVersion.clear();
-        headers.clear();
-        bodyData.clear();
-        contentLength = 0;
-        headerComplete = false;
-        complete = false;
+        *this = RequestParser(buffer.get_allocator().resource());
     }
 
     void parse(std::string_view data) {
@@ -41,35 +41,38 @@ public:
         return complete;
     }
 
-    const std::string& getMethod() const {
+    std::string_view getMethod() const {
         return method;
     }
 
-    const std::string& getUrl() const {
+    std::string_view getUrl() const {
         return url;
     }
 
-    const std::string& getPath() const {
+    std::string_view getPath() const {
         return path;
     }
 
-    const std::string& getHttpVersion() const {
+    std::string_view getHttpVersion() const {
         return httpVersion;
     }
 
-    std::string getHeader(const std::string& key) const {
-        auto it = headers.find(key);
-        if (it != headers.end()) {
-            return it->second;
+    // 键使用规范化形式（如"Content-Length"），不存在时返回空视图
+    std::string_view getHeader(std::string_view key) const {
+        // 头部通常只有十几个，线性查找即可
+        for (auto it = headers.rbegin(); it != headers.rend(); ++it) {
+            if (it->first == key) {
+                return it->second;
+            }
         }
-        return "";
+        return {};
     }
 
-    const std::unordered_map<std::string, std::string>& getHeaders() const {
+    const HeaderList& getHeaders() const {
         return headers;
     }
 
-    const std::string& getBody() const {
+    std::string_view getBody() const {
         return bodyData;
     }
 
@@ -84,8 +87,7 @@ private:
         // 提取并解析请求行
         size_t lineEnd = buffer.find("\r\n");
         if (lineEnd != std::string::npos) {
-            std::string requestLine = buffer.substr(0, lineEnd);
-            parseRequestLine(requestLine);
+            parseRequestLine(std::string_view(buffer).substr(0, lineEnd));
         }
 
         // 解析头部字段
@@ -96,17 +98,15 @@ private:
                 break;
             }
 
-            std::string headerLine = buffer.substr(pos, nextLineEnd - pos);
-            parseHeaderLine(headerLine);
+            parseHeaderLine(std::string_view(buffer).substr(pos, nextLineEnd - pos));
             pos = nextLineEnd + 2; // 跳过这一行的\r\n
         }
 
         // 获取Content-Length
-        std::string contentLengthStr = getHeader("Content-Length");
+        std::string_view contentLengthStr = getHeader("Content-Length");
         if (!contentLengthStr.empty()) {
-            try {
-                contentLength = std::stoul(contentLengthStr);
-            } catch (...) {
+            auto [ptr, ec] = std::from_chars(contentLengthStr.data(), contentLengthStr.data() + contentLengthStr.size(), contentLength);
+            if (ec != std::errc()) {
                 contentLength = 0;
             }
         }
@@ -115,7 +115,7 @@ private:
         headerComplete = true;
 
         // 将headerEnd之后的数据作为消息体
-        bodyData = buffer.substr(headerEnd + 4); // +4 跳过\r\n\r\n
+        bodyData.assign(std::string_view(buffer).substr(headerEnd + 4)); // +4 跳过\r\n\r\n
 
         // 检查请求是否已完成
         parseBody();
@@ -133,60 +133,53 @@ private:
         }
     }
 
-    void parseRequestLine(const std::string& line) {
+    void parseRequestLine(std::string_view line) {
         // 解析请求方法
         size_t methodEnd = line.find(' ');
         if (methodEnd != std::string::npos) {
-            method = line.substr(0, methodEnd);
+            method.assign(line.substr(0, methodEnd));
             // 转换为大写
             std::transform(method.begin(), method.end(), method.begin(), ::toupper);
             
             // 解析URL
             size_t urlEnd = line.find(' ', methodEnd + 1);
             if (urlEnd != std::string::npos) {
-                url = line.substr(methodEnd + 1, urlEnd - methodEnd - 1);
+                url.assign(line.substr(methodEnd + 1, urlEnd - methodEnd - 1));
                 
                 // 解析HTTP版本
-                httpVersion = line.substr(urlEnd + 1);
+                httpVersion.assign(line.substr(urlEnd + 1));
                 
                 // 解析path部分（移除查询参数）
-                size_t queryStart = url.find('?');
-                if (queryStart != std::string::npos) {
-                    path = url.substr(0, queryStart);
-                } else {
-                    path = url;
-                }
+                path.assign(std::string_view(url).substr(0, url.find('?')));
             }
         }
     }
 
-    void parseHeaderLine(const std::string& line) {
+    void parseHeaderLine(std::string_view line) {
         size_t colonPos = line.find(':');
-        if (colonPos != std::string::npos) {
-            std::string key = line.substr(0, colonPos);
-            std::string value = line.substr(colonPos + 1);
-            
+        if (colonPos != std::string_view::npos) {
             // 移除前后空格
-            key = trimString(key);
-            value = trimString(value);
+            std::string_view key = trimString(line.substr(0, colonPos));
+            std::string_view value = trimString(line.substr(colonPos + 1));
             
-            // 存储头部字段（不区分大小写的键）
-            headers[normalizeHeaderKey(key)] = value;
+            // 存储头部字段（不区分大小写的键），重复的键以最后一个为准
+            headers.emplace_back(normalizeHeaderKey(key), String(value, headers.get_allocator()));
         }
     }
 
-    std::string trimString(const std::string& str) {
+    static std::string_view trimString(std::string_view str) {
         size_t first = str.find_first_not_of(" \t");
-        if (first == std::string::npos) {
-            return "";
+        if (first == std::string_view::npos) {
+            return {};
         }
         size_t last = str.find_last_not_of(" \t");
         return str.substr(first, last - first + 1);
     }
 
     // 规范化头部键（首字母大写，其余小写）
-    std::string normalizeHeaderKey(const std::string& key) {
-        std::string normalized;
+    String normalizeHeaderKey(std::string_view key) {
+        String normalized(headers.get_allocator());
+        normalized.reserve(key.size());
         bool nextUpper = true;
         
         for (char c : key) {
@@ -204,13 +197,13 @@ private:
         return normalized;
     }
 
-    std::string buffer;            // 请求数据缓冲区
-    std::string method;            // 请求方法（GET、POST等）
-    std::string url;               // 完整URL
-    std::string path;              // URL路径部分
-    std::string httpVersion;       // HTTP版本
-    std::unordered_map<std::string, std::string> headers; // 头部字段
-    std::string bodyData;          // 请求体数据
+    String buffer;                 // 请求数据缓冲区
+    String method;                 // 请求方法（GET、POST等）
+    String url;                    // 完整URL
+    String path;                   // URL路径部分
+    String httpVersion;            // HTTP版本
+    HeaderList headers;            // 头部字段
+    String bodyData;               // 请求体数据
     size_t contentLength;          // Content-Length值
     bool headerComplete;           // 标记头部是否解析完成
     bool complete;                 // 标记整个请求是否解析完成
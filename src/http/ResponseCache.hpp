@@ -0,0 +1,105 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <ctime>
+#include <fmt/format.h>
+#include "HttpServer.hpp"
+#include "ResponseHeaders.hpp"
+
+// 预序列化的完整响应：状态行和固定头部已渲染好，与响应体一起缓存
+// headerBlock 不包含 Date 头、Connection 头和结尾空行，由每个请求按需补上
+// body 指向 storage 持有的内容，可以是堆上的字符串、内存池中的块或只读文件映射
+struct CachedResponse {
+    int statusCode;
+    std::string mimeType;
+    std::string headerBlock;
+    std::string_view body;
+    std::shared_ptr<const void> storage;
+};
+
+class ResponseCache {
+public:
+    static ResponseCache& getInstance() {
+        static ResponseCache instance;
+        return instance;
+    }
+
+    // 渲染固定头部块（状态行、Server、Content-Type、Content-Length及额外头部）
+    static std::string buildHeaderBlock(int statusCode, std::string_view contentType,
+                                        size_t contentLength, std::string_view extraHeaders = {}) {
+        std::string block;
+        block.reserve(128 + contentType.size() + extraHeaders.size());
+        HttpStatus::append(block, statusCode);
+        block.append(HttpServer::HttpResponse::SERVER_HEADER);
+        fmt::format_to(std::back_inserter(block),
+            "Content-Type: {}\r\n"
+            "Content-Length: {}\r\n",
+            contentType, contentLength);
+        block.append(extraHeaders);
+        return block;
+    }
+
+    // 构建一个不可变的预序列化响应，内容保存在堆上
+    static std::shared_ptr<const CachedResponse> build(int statusCode, std::string mimeType,
+                                                       std::string body, std::string_view extraHeaders = {}) {
+        auto storage = std::make_shared<const std::string>(std::move(body));
+        std::string_view view(*storage);
+        return build(statusCode, std::move(mimeType), view, std::move(storage), extraHeaders);
+    }
+
+    // 构建一个不可变的预序列化响应，内容由storage持有（内存池块或文件映射）
+    static std::shared_ptr<const CachedResponse> build(int statusCode, std::string mimeType, std::string_view body,
+                                                       std::shared_ptr<const void> storage,
+                                                       std::string_view extraHeaders = {}) {
+        auto response = std::make_shared<CachedResponse>();
+        response->statusCode = statusCode;
+        response->headerBlock = buildHeaderBlock(statusCode, mimeType, body.size(), extraHeaders);
+        response->mimeType = std::move(mimeType);
+        response->body = body;
+        response->storage = std::move(storage);
+        return response;
+    }
+
+    // 生成缓存验证器头部（ETag 和 Last-Modified）
+    // etagSuffix用于区分同一文件的不同编码版本（如压缩版本）
+    static std::string buildValidators(uintmax_t size, std::time_t mtime, std::string_view etagSuffix = {}) {
+        char lastModified[HttpDate::LENGTH];
+        size_t length = HttpDate::format(mtime, lastModified);
+        return fmt::format(
+            "ETag: \"{:x}-{:x}{}\"\r\n"
+            "Last-Modified: {}\r\n",
+            static_cast<uintmax_t>(mtime), size, etagSuffix, std::string_view(lastModified, length));
+    }
+
+    // 获取固定错误页面，未知状态码返回500页面
+    std::shared_ptr<const CachedResponse> getErrorPage(int statusCode) const {
+        auto it = errorPages.find(statusCode);
+        if (it != errorPages.end()) {
+            return it->second;
+        }
+        return errorPages.at(500);
+    }
+
+private:
+    // 错误页面在构造时一次性渲染，之后只读，无需加锁
+    ResponseCache() {
+        addErrorPage(403, "<html><body><h1>403 Forbidden</h1><p>您没有权限访问此资源。</p></body></html>");
+        addErrorPage(404, "<html><body><h1>404 Not Found</h1><p>您请求的资源在此服务器上未找到。</p></body></html>");
+        addErrorPage(500, "<html><body><h1>500 Internal Server Error</h1><p>服务器遇到意外条件，无法完成请求。</p></body></html>");
+        addErrorPage(501, "<html><body><h1>501 未实现</h1><p>服务器不支持此请求方法。</p></body></html>");
+    }
+
+    // 删除复制和移动构造/赋值
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+    ResponseCache(ResponseCache&&) = delete;
+    ResponseCache& operator=(ResponseCache&&) = delete;
+
+    void addErrorPage(int statusCode, std::string body) {
+        errorPages[statusCode] = build(statusCode, "text/html; charset=UTF-8", std::move(body));
+    }
+
+    std::unordered_map<int, std::shared_ptr<const CachedResponse>> errorPages;
+};
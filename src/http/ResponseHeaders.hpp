@@ -0,0 +1,194 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <fmt/format.h>
+
+namespace status_table {
+
+struct Entry {
+    int code;
+    std::string_view line;
+};
+
+inline constexpr int MAX_CODE = 600;
+inline constexpr uint8_t NONE = 0xff;
+
+// 常用状态码的完整状态行，编译期渲染好
+inline constexpr Entry ENTRIES[] = {
+    {200, "HTTP/1.1 200 OK\r\n"},
+    {201, "HTTP/1.1 201 Created\r\n"},
+    {204, "HTTP/1.1 204 No Content\r\n"},
+    {206, "HTTP/1.1 206 Partial Content\r\n"},
+    {301, "HTTP/1.1 301 Moved Permanently\r\n"},
+    {302, "HTTP/1.1 302 Found\r\n"},
+    {304, "HTTP/1.1 304 Not Modified\r\n"},
+    {400, "HTTP/1.1 400 Bad Request\r\n"},
+    {401, "HTTP/1.1 401 Unauthorized\r\n"},
+    {403, "HTTP/1.1 403 Forbidden\r\n"},
+    {404, "HTTP/1.1 404 Not Found\r\n"},
+    {405, "HTTP/1.1 405 Method Not Allowed\r\n"},
+    {413, "HTTP/1.1 413 Payload Too Large\r\n"},
+    {500, "HTTP/1.1 500 Internal Server Error\r\n"},
+    {501, "HTTP/1.1 501 Not Implemented\r\n"},
+    {502, "HTTP/1.1 502 Bad Gateway\r\n"},
+    {503, "HTTP/1.1 503 Service Unavailable\r\n"},
+};
+
+// 状态码到ENTRIES下标的索引，未收录的状态码为NONE
+constexpr std::array<uint8_t, MAX_CODE> buildIndex() {
+    std::array<uint8_t, MAX_CODE> index{};
+    for (auto& slot : index) {
+        slot = NONE;
+    }
+    for (size_t i = 0; i < std::size(ENTRIES); ++i) {
+        index[ENTRIES[i].code] = static_cast<uint8_t>(i);
+    }
+    return index;
+}
+
+inline constexpr std::array<uint8_t, MAX_CODE> INDEX = buildIndex();
+
+} // namespace status_table
+
+// 状态行表：按数字状态码直接索引预渲染的状态行，不再查字符串映射
+class HttpStatus {
+public:
+    // 返回"HTTP/1.1 200 OK\r\n"形式的状态行，表中没有的状态码返回空视图
+    static constexpr std::string_view statusLine(int code) {
+        using namespace status_table;
+        return (code >= 0 && code < MAX_CODE && INDEX[code] != NONE) ? ENTRIES[INDEX[code]].line : std::string_view{};
+    }
+
+    // 返回原因短语，表中没有的状态码返回空视图
+    static constexpr std::string_view reason(int code) {
+        std::string_view line = statusLine(code);
+        // 去掉"HTTP/1.1 200 "和结尾的"\r\n"
+        return line.empty() ? line : line.substr(13, line.size() - 15);
+    }
+
+    // 把状态行追加到out，表中没有的状态码现场格式化
+    template <typename Buffer>
+    static void append(Buffer& out, int code) {
+        std::string_view line = statusLine(code);
+        if (!line.empty()) {
+            out.append(line);
+        } else {
+            fmt::format_to(std::back_inserter(out), "HTTP/1.1 {} \r\n", code);
+        }
+    }
+};
+
+static_assert(HttpStatus::reason(404) == "Not Found");
+
+// RFC 7231 HTTP日期（IMF-fixdate），不使用strftime，避免受进程locale影响
+class HttpDate {
+public:
+    static constexpr size_t LENGTH = 29; // "Sun, 06 Nov 1994 08:49:37 GMT"
+    static constexpr size_t HEADER_LENGTH = LENGTH + 8; // "Date: " + 日期 + "\r\n"
+
+    // 格式化到out（至少LENGTH字节），返回写入的长度
+    static size_t format(std::time_t time, char* out) {
+        static constexpr const char* DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static constexpr const char* MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        std::tm tm{};
+        gmtime_r(&time, &tm);
+        auto end = fmt::format_to_n(out, LENGTH, "{}, {:02} {} {} {:02}:{:02}:{:02} GMT",
+            DAYS[tm.tm_wday], tm.tm_mday, MONTHS[tm.tm_mon], tm.tm_year + 1900,
+            tm.tm_hour, tm.tm_min, tm.tm_sec);
+        return end.out - out;
+    }
+
+    // 当前时间的"Date: ...\r\n"头部，每个线程每秒只格式化一次
+    // 返回的视图在下一秒被覆盖，需要跨越挂起点使用时应复制
+    static std::string_view currentHeader() {
+        thread_local std::time_t cachedSecond = -1;
+        thread_local char buffer[HEADER_LENGTH];
+        thread_local size_t length = 0;
+
+        std::time_t now = std::time(nullptr);
+        if (now != cachedSecond) {
+            cachedSecond = now;
+            std::memcpy(buffer, "Date: ", 6);
+            size_t dateLength = format(now, buffer + 6);
+            std::memcpy(buffer + 6 + dateLength, "\r\n", 2);
+            length = dateLength + 8;
+        }
+        return std::string_view(buffer, length);
+    }
+};
+
+// 固定容量的响应头部表，不分配内存；名称和值是视图，必须在序列化之前保持有效
+template <size_t Capacity>
+class FixedHeaderList {
+public:
+    struct Header {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // 已存在的头部被替换；超出容量时抛出异常
+    void set(std::string_view name, std::string_view value) {
+        for (size_t i = 0; i < count; ++i) {
+            if (headers[i].name == name) {
+                headers[i].value = value;
+                return;
+            }
+        }
+        if (count == Capacity) {
+            throw std::length_error("响应头部数量超出上限");
+        }
+        headers[count++] = Header{name, value};
+    }
+
+    void remove(std::string_view name) {
+        for (size_t i = 0; i < count; ++i) {
+            if (headers[i].name == name) {
+                headers[i] = headers[--count];
+                return;
+            }
+        }
+    }
+
+    std::string_view get(std::string_view name) const {
+        for (size_t i = 0; i < count; ++i) {
+            if (headers[i].name == name) {
+                return headers[i].value;
+            }
+        }
+        return {};
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    const Header* begin() const {
+        return headers.data();
+    }
+
+    const Header* end() const {
+        return headers.data() + count;
+    }
+
+    // 序列化为"名称: 值\r\n"追加到out
+    template <typename Buffer>
+    void appendTo(Buffer& out) const {
+        for (size_t i = 0; i < count; ++i) {
+            out.append(headers[i].name).append(": ").append(headers[i].value).append("\r\n");
+        }
+    }
+
+private:
+    std::array<Header, Capacity> headers;
+    size_t count{0};
+};
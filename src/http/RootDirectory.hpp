@@ -0,0 +1,97 @@
+#pragma once
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#endif
+
+// 根目录句柄：启动时打开一次，之后所有文件都相对它打开
+// 优先使用openat2(RESOLVE_BENEATH|RESOLVE_NO_MAGICLINKS)，由内核保证解析结果不越出根目录
+// （包括指向根目录之外的符号链接）；内核不支持时回退到openat
+class RootDirectory {
+public:
+    RootDirectory() = default;
+
+    ~RootDirectory() {
+        if (dirFd != -1) {
+            ::close(dirFd);
+        }
+    }
+
+    // 删除复制和移动构造/赋值
+    RootDirectory(const RootDirectory&) = delete;
+    RootDirectory& operator=(const RootDirectory&) = delete;
+    RootDirectory(RootDirectory&&) = delete;
+    RootDirectory& operator=(RootDirectory&&) = delete;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1) {
+            LOG_ERROR("根目录不存在或无法访问: {} ({})", path, strerror(errno));
+            return false;
+        }
+        if (dirFd != -1) {
+            ::close(dirFd);
+        }
+        dirFd = fd;
+        return true;
+    }
+
+    // 相对根目录打开文件，relativePath为空时打开根目录本身
+    // 失败返回-1并设置errno，越出根目录时为EXDEV
+    int openBeneath(const std::string& relativePath, int flags) const {
+        const char* path = relativePath.empty() ? "." : relativePath.c_str();
+#if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+        if (openat2Supported.load(std::memory_order_relaxed)) {
+            struct open_how how{};
+            how.flags = static_cast<uint64_t>(flags | O_CLOEXEC);
+            how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+            long fd;
+            do {
+                fd = ::syscall(SYS_openat2, dirFd, path, &how, sizeof(how));
+            } while (fd == -1 && errno == EAGAIN);
+            if (fd != -1 || errno != ENOSYS) {
+                return static_cast<int>(fd);
+            }
+            openat2Supported.store(false, std::memory_order_relaxed);
+            LOG_WARNING("内核不支持openat2，回退到openat");
+        }
+#endif
+        // openat无法限制解析范围，至少拒绝绝对路径和".."分段
+        if (!isContained(relativePath)) {
+            errno = EXDEV;
+            return -1;
+        }
+        return ::openat(dirFd, path, flags | O_CLOEXEC);
+    }
+
+private:
+    static bool isContained(std::string_view path) {
+        if (!path.empty() && path[0] == '/') {
+            return false;
+        }
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find('/', start);
+            if (end == std::string_view::npos) {
+                end = path.size();
+            }
+            if (path.substr(start, end - start) == "..") {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    int dirFd{-1};
+    mutable std::atomic<bool> openat2Supported{true};
+};
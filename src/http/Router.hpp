@@ -0,0 +1,319 @@
+#pragma once
+#include <array>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "HttpServer.hpp"
+#include "ResponseCache.hpp"
+#include "../core/Task.hpp"
+#include "../network/AsyncIO.hpp"
+#include "../utils/EventLoopMonitor.hpp"
+
+// 路由参数：":name"和"*name"捕获的路径片段，是指向请求路径的视图
+// 容量固定，匹配时不分配内存；注册时保证单条路由的参数个数不超过容量
+class RouteParams {
+public:
+    static constexpr size_t CAPACITY = 8;
+
+    // 不存在时返回空视图
+    std::string_view get(std::string_view name) const {
+        for (size_t i = 0; i < count; ++i) {
+            if (params[i].first == name) {
+                return params[i].second;
+            }
+        }
+        return {};
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+private:
+    friend class Router;
+
+    void push(std::string_view name, std::string_view value) {
+        params[count++] = {name, value};
+    }
+
+    void truncate(size_t size) {
+        count = size;
+    }
+
+    std::array<std::pair<std::string_view, std::string_view>, CAPACITY> params;
+    size_t count{0};
+};
+
+// 一次请求的处理上下文，由连接协程创建并传给路由处理函数
+struct RequestContext {
+    HttpServer::HttpRequest& request;
+    HttpServer::HttpResponse& response;
+    int fd;
+    int epollFd;
+    RouteParams params;
+    RequestTimeline* timeline;   // 启用性能监控时非空，处理函数把加载耗时记在这里
+    std::string_view route;      // 匹配到的路由模式，为空表示未匹配
+    bool responseStarted{false}; // 响应已开始发送，之后出错不能再改为错误页面
+
+    RequestContext(HttpServer::HttpRequest& request, HttpServer::HttpResponse& response, int fd, int epollFd,
+                   RequestTimeline* timeline = nullptr)
+        : request(request), response(response), fd(fd), epollFd(epollFd), timeline(timeline) {}
+
+    // 使用缓存的固定错误页面作为响应
+    void setErrorPage(int statusCode, bool headOnly = false) {
+        auto page = ResponseCache::getInstance().getErrorPage(statusCode);
+        response.setStatus(page->statusCode);
+        response.setPrebuilt(page->headerBlock, headOnly ? std::string_view{} : std::string_view(page->body), page);
+    }
+
+    // 协程被事件循环恢复后调用，把这次恢复的耗时记到本请求的路由上
+    void noteResumed() const {
+        EventLoopMonitor::getInstance().noteRoute(route.empty() ? std::string_view("(unmatched)") : route);
+    }
+
+    // 发送当前准备好的响应（或下一个分块），大响应可能需要多次等待socket可写
+    SubTask send() {
+        responseStarted = true;
+        do {
+            co_await HttpServer::HttpResponseAwaiter(response, fd, epollFd);
+            noteResumed();
+        } while (!response.isWriteComplete());
+    }
+
+    // 让出事件循环，socket可写时（通常是下一次epoll_wait）再继续
+    // 逐块生成大响应的处理函数在块之间调用，快速客户端不会只在EAGAIN时才让出
+    SubTask yield() {
+        if (timeline) {
+            timeline->pauseHandler();
+        }
+        co_await WritableAwaiter(fd, epollFd);
+        if (timeline) {
+            timeline->resumeHandler();
+        }
+        noteResumed();
+    }
+};
+
+// 路由表：压缩前缀树（radix tree），支持静态片段、":name"参数片段和"*name"通配片段
+// 匹配优先级为静态 > 参数 > 通配，按方法分派到注册的协程处理函数
+// 路由在启动时注册，之后只读；匹配的开销与路径长度成正比，不分配内存
+class Router {
+public:
+    // 处理函数是协程，由连接协程co_await；处理函数可以自己调用ctx.send()流式发送，
+    // 否则返回后由连接协程发送准备好的响应
+    using Handler = SubTask (*)(RequestContext&);
+
+    struct Match {
+        Handler handler;   // 为nullptr时表示没有可用的处理函数
+        bool pathMatched;  // 路径匹配但方法没有注册
+        std::string_view route; // 匹配到的路由模式，用于按路由统计；路径未匹配时为空
+    };
+
+    static Router& getInstance() {
+        static Router instance;
+        return instance;
+    }
+
+    // 注册路由，method为"*"时匹配任意方法；模式不合法或与已有路由冲突时抛出异常
+    void add(std::string_view method, std::string_view pattern, Handler handler) {
+        if (pattern.empty() || pattern[0] != '/') {
+            throw std::invalid_argument("路由模式必须以'/'开头: " + std::string(pattern));
+        }
+        size_t index = methodIndex(method);
+        if (index == OTHER_METHOD && method != "*") {
+            throw std::invalid_argument("不支持注册的方法: " + std::string(method));
+        }
+        Node* node = insert(pattern);
+        node->pattern = pattern;
+        Handler& slot = index == OTHER_METHOD ? node->anyMethod : node->handlers[index];
+        if (slot != nullptr) {
+            throw std::invalid_argument("路由重复注册: " + std::string(method) + " " + std::string(pattern));
+        }
+        slot = handler;
+    }
+
+    // 把prefix下的所有路径挂载到handler（GET和HEAD），剩余部分以"path"参数传入
+    void mount(std::string_view prefix, Handler handler) {
+        std::string pattern(prefix);
+        if (pattern.empty() || pattern.back() != '/') {
+            pattern.push_back('/');
+        }
+        pattern.append("*path");
+        add("GET", pattern, handler);
+        add("HEAD", pattern, handler);
+    }
+
+    // 查找method和path对应的处理函数，捕获的参数写入params
+    // HEAD没有单独注册时使用GET的处理函数，响应体由连接协程在发送前去掉
+    Match match(std::string_view method, std::string_view path, RouteParams& params) const {
+        params.clear();
+        const Node* node = find(root, path, params);
+        if (node == nullptr) {
+            return {nullptr, false, {}};
+        }
+        size_t index = methodIndex(method);
+        Handler handler = index != OTHER_METHOD ? node->handlers[index] : nullptr;
+        if (handler == nullptr && index == HEAD_METHOD) {
+            handler = node->handlers[GET_METHOD];
+        }
+        return {handler != nullptr ? handler : node->anyMethod, true, node->pattern};
+    }
+
+private:
+    static constexpr std::string_view METHODS[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH"};
+    static constexpr size_t METHOD_COUNT = std::size(METHODS);
+    static constexpr size_t OTHER_METHOD = METHOD_COUNT; // 未列出的方法只能匹配"*"路由
+    static constexpr size_t GET_METHOD = 0;
+    static constexpr size_t HEAD_METHOD = 1;
+
+    struct Node {
+        std::string prefix;                          // 静态边的标签
+        std::string indices;                         // 各静态子节点标签的首字符，与children一一对应
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> paramChild;            // ":name"，匹配到下一个'/'为止的非空片段
+        std::unique_ptr<Node> wildcardChild;         // "*name"，匹配剩余的全部路径（可以为空）
+        std::string paramName;                       // 参数子节点捕获的名称
+        std::string wildcardName;                    // 通配子节点捕获的名称
+        std::array<Handler, METHOD_COUNT> handlers{};
+        Handler anyMethod{nullptr};
+        std::string pattern;                         // 注册时的完整模式，注册后不再改变
+
+        bool hasHandlers() const {
+            if (anyMethod != nullptr) {
+                return true;
+            }
+            for (Handler handler : handlers) {
+                if (handler != nullptr) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    Router() = default;
+
+    // 删除复制和移动构造/赋值
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+    Router(Router&&) = delete;
+    Router& operator=(Router&&) = delete;
+
+    static size_t methodIndex(std::string_view method) {
+        for (size_t i = 0; i < METHOD_COUNT; ++i) {
+            if (METHODS[i] == method) {
+                return i;
+            }
+        }
+        return OTHER_METHOD;
+    }
+
+    // 沿模式插入（必要时分裂已有的静态边），返回模式对应的节点
+    Node* insert(std::string_view pattern) {
+        Node* node = &root;
+        size_t paramCount = 0;
+        while (!pattern.empty()) {
+            if (pattern[0] == ':' || pattern[0] == '*') {
+                bool wildcard = pattern[0] == '*';
+                size_t end = wildcard ? pattern.size() : pattern.find('/');
+                std::string_view name = pattern.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+                if (name.empty() || name.find_first_of(":*/") != std::string_view::npos) {
+                    throw std::invalid_argument("路由参数名不合法: " + std::string(pattern));
+                }
+                if (++paramCount > RouteParams::CAPACITY) {
+                    throw std::invalid_argument("路由参数过多: " + std::string(pattern));
+                }
+                // 同一位置的参数（或通配）在不同路由中必须同名
+                std::string& existing = wildcard ? node->wildcardName : node->paramName;
+                if (!existing.empty() && existing != name) {
+                    throw std::invalid_argument("路由参数名冲突: " + std::string(name) + " 与 " + existing);
+                }
+                auto& child = wildcard ? node->wildcardChild : node->paramChild;
+                if (!child) {
+                    child = std::make_unique<Node>();
+                }
+                existing = name;
+                node = child.get();
+                pattern = end == std::string_view::npos ? std::string_view{} : pattern.substr(end);
+                continue;
+            }
+
+            // 静态片段一直延伸到下一个参数或通配
+            std::string_view segment = pattern.substr(0, pattern.find_first_of(":*"));
+            size_t index = node->indices.find(segment[0]);
+            if (index == std::string::npos) {
+                auto child = std::make_unique<Node>();
+                child->prefix = segment;
+                node->indices.push_back(segment[0]);
+                node->children.push_back(std::move(child));
+                node = node->children.back().get();
+                pattern.remove_prefix(segment.size());
+                continue;
+            }
+
+            Node* child = node->children[index].get();
+            size_t common = 0;
+            while (common < segment.size() && common < child->prefix.size() &&
+                   segment[common] == child->prefix[common]) {
+                ++common;
+            }
+            if (common < child->prefix.size()) {
+                // 分裂：公共前缀成为新的中间节点，原节点挂在其下
+                auto middle = std::make_unique<Node>();
+                middle->prefix = child->prefix.substr(0, common);
+                auto original = std::move(node->children[index]);
+                original->prefix.erase(0, common);
+                middle->indices.push_back(original->prefix[0]);
+                middle->children.push_back(std::move(original));
+                node->children[index] = std::move(middle);
+                child = node->children[index].get();
+            }
+            node = child;
+            pattern.remove_prefix(common);
+        }
+        return node;
+    }
+
+    // 按静态 > 参数 > 通配的优先级匹配，前面的分支失败时回溯
+    static const Node* find(const Node& node, std::string_view path, RouteParams& params) {
+        if (path.empty() && node.hasHandlers()) {
+            return &node;
+        }
+        if (!path.empty()) {
+            size_t index = node.indices.find(path[0]);
+            if (index != std::string::npos) {
+                const Node& child = *node.children[index];
+                if (path.starts_with(child.prefix)) {
+                    if (const Node* found = find(child, path.substr(child.prefix.size()), params)) {
+                        return found;
+                    }
+                }
+            }
+            if (node.paramChild) {
+                std::string_view segment = path.substr(0, path.find('/'));
+                if (!segment.empty()) {
+                    size_t mark = params.size();
+                    params.push(node.paramName, segment);
+                    if (const Node* found = find(*node.paramChild, path.substr(segment.size()), params)) {
+                        return found;
+                    }
+                    params.truncate(mark);
+                }
+            }
+        }
+        if (node.wildcardChild && node.wildcardChild->hasHandlers()) {
+            params.push(node.wildcardName, path);
+            return node.wildcardChild.get();
+        }
+        return nullptr;
+    }
+
+    Node root;
+};
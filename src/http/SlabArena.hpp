@@ -0,0 +1,187 @@
+#pragma once
+#include <sys/mman.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+
+// 小文件内存池：一整块连续的匿名映射，按大小等级切分为slab，每个slab只存放同一等级的块
+// 可选MADV_HUGEPAGE，使缓存的小文件集中在少量大页上，减少TLB未命中
+// 块由shared_ptr句柄持有，最后一个引用释放时归还到所属等级的空闲链表
+class SlabArena : public std::enable_shared_from_this<SlabArena> {
+public:
+    struct Stats {
+        size_t capacity;      // 内存池总容量
+        size_t committed;     // 已切分给各等级的slab字节数
+        size_t used;          // 已分配块占用的字节数（按等级大小计）
+        size_t requested;     // 已分配块实际存放的字节数
+        size_t allocations;   // 当前存活的块数
+        size_t failures;      // 内存池已满导致的分配失败次数
+        bool hugePages;
+    };
+
+    // 创建内存池，失败返回nullptr
+    static std::shared_ptr<SlabArena> create(size_t capacity, size_t maxObjectSize, bool hugePages) {
+        auto arena = std::shared_ptr<SlabArena>(new SlabArena());
+        if (!arena->init(capacity, maxObjectSize, hugePages)) {
+            return nullptr;
+        }
+        return arena;
+    }
+
+    ~SlabArena() {
+        if (region != nullptr) {
+            ::munmap(mappingBase, mappingLength);
+        }
+    }
+
+    // 删除复制和移动构造/赋值
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+    SlabArena(SlabArena&&) = delete;
+    SlabArena& operator=(SlabArena&&) = delete;
+
+    // 分配可存放size字节的块，内存池已满或超过最大块大小时返回nullptr
+    std::shared_ptr<char> allocate(size_t size) {
+        size_t classIndex = classFor(size);
+        if (classIndex == classSizes.size()) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        char* block = popFree(classIndex);
+        if (block == nullptr && carveSlab(classIndex)) {
+            block = popFree(classIndex);
+        }
+        if (block == nullptr) {
+            failures++;
+            return nullptr;
+        }
+        usedBytes += classSizes[classIndex];
+        requestedBytes += size;
+        allocations++;
+
+        auto self = shared_from_this();
+        return std::shared_ptr<char>(block, [self, classIndex, size](char* p) {
+            self->release(p, classIndex, size);
+        });
+    }
+
+    size_t getMaxObjectSize() const {
+        return classSizes.empty() ? 0 : classSizes.back();
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return Stats{capacity, committedBytes, usedBytes, requestedBytes, allocations, failures, hugePages};
+    }
+
+private:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t MIN_SLAB_SIZE = 256 * 1024;
+    static constexpr size_t MIN_CLASS_SIZE = 64;
+    static constexpr size_t SLOTS_PER_SLAB = 4; // 大块等级的slab至少容纳的块数
+
+    SlabArena() = default;
+
+    bool init(size_t requestedCapacity, size_t maxObjectSize, bool useHugePages) {
+        capacity = (requestedCapacity + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        if (capacity == 0) {
+            return false;
+        }
+
+        // 多映射一个大页的长度，以便把起始地址对齐到大页边界
+        mappingLength = capacity + (useHugePages ? HUGE_PAGE_SIZE : 0);
+        void* mapped = ::mmap(nullptr, mappingLength, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("小文件内存池映射失败: {}", strerror(errno));
+            return false;
+        }
+        mappingBase = mapped;
+        region = static_cast<char*>(mapped);
+        if (useHugePages) {
+            auto address = reinterpret_cast<uintptr_t>(region);
+            region += (HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+            // 内核未启用透明大页时失败，不影响使用
+            hugePages = ::madvise(region, capacity, MADV_HUGEPAGE) == 0;
+            if (!hugePages) {
+                LOG_WARNING("小文件内存池无法启用大页: {}", strerror(errno));
+            }
+        }
+
+        // 每个2的幂区间内再细分4个等级，块内浪费不超过25%
+        for (size_t size = MIN_CLASS_SIZE; ; ) {
+            classSizes.push_back(size);
+            if (size >= maxObjectSize) break;
+            size_t step = std::max<size_t>(std::bit_floor(size) / 4, 16);
+            size += step;
+        }
+        freeLists.assign(classSizes.size(), nullptr);
+        return true;
+    }
+
+    size_t classFor(size_t size) const {
+        return std::lower_bound(classSizes.begin(), classSizes.end(), std::max<size_t>(size, 1)) - classSizes.begin();
+    }
+
+    // 空闲块的前8字节保存下一个空闲块的地址
+    char* popFree(size_t classIndex) {
+        char* block = freeLists[classIndex];
+        if (block != nullptr) {
+            std::memcpy(&freeLists[classIndex], block, sizeof(char*));
+        }
+        return block;
+    }
+
+    void pushFree(size_t classIndex, char* block) {
+        std::memcpy(block, &freeLists[classIndex], sizeof(char*));
+        freeLists[classIndex] = block;
+    }
+
+    // 从内存池尾部切出一个新slab，全部放入该等级的空闲链表
+    bool carveSlab(size_t classIndex) {
+        size_t classSize = classSizes[classIndex];
+        size_t slabSize = std::max(MIN_SLAB_SIZE, classSize * SLOTS_PER_SLAB);
+        slabSize = std::min(slabSize, capacity - committedBytes) / classSize * classSize;
+        if (slabSize == 0) {
+            return false;
+        }
+        char* slab = region + committedBytes;
+        committedBytes += slabSize;
+        for (size_t offset = slabSize; offset >= classSize; offset -= classSize) {
+            pushFree(classIndex, slab + offset - classSize);
+        }
+        return true;
+    }
+
+    void release(char* block, size_t classIndex, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pushFree(classIndex, block);
+        usedBytes -= classSizes[classIndex];
+        requestedBytes -= size;
+        allocations--;
+    }
+
+    void* mappingBase{nullptr};
+    size_t mappingLength{0};
+    char* region{nullptr};
+    size_t capacity{0};
+    bool hugePages{false};
+
+    std::vector<size_t> classSizes;   // 各等级的块大小，递增
+    std::vector<char*> freeLists;     // 各等级的空闲链表头
+
+    mutable std::mutex mutex;
+    size_t committedBytes{0};
+    size_t usedBytes{0};
+    size_t requestedBytes{0};
+    size_t allocations{0};
+    size_t failures{0};
+};
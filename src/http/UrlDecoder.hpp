@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 请求级暂存区：解码结果存放在一块复用的缓冲区中，请求之间只重置不释放
+// 调用方保证容量足够（解码结果不会比原文长），分配期间缓冲区不会移动，返回的视图在reset前有效
+class ScratchArena {
+public:
+    // 清空暂存区并确保至少有capacity字节可用；只能在没有存活视图时调用
+    void reset(size_t capacity = 0) {
+        used = 0;
+        if (storage.size() < capacity) {
+            storage.resize(capacity);
+        }
+    }
+
+    // 容量不足时返回nullptr
+    char* allocate(size_t size) {
+        if (size > storage.size() - used) {
+            return nullptr;
+        }
+        char* p = storage.data() + used;
+        used += size;
+        return p;
+    }
+
+    bool empty() const {
+        return used == 0;
+    }
+
+private:
+    std::vector<char> storage;
+    size_t used{0};
+};
+
+// 百分号解码（RFC 3986），不含转义的常见情况直接返回原视图，不复制
+class UrlDecoder {
+public:
+    // 是否需要解码：含有'%'，或查询串中含有表示空格的'+'
+    static bool needsDecoding(std::string_view text, bool plusAsSpace) {
+        const char* p = text.data();
+        const char* end = p + text.size();
+#if defined(__SSE2__)
+        // 每次比较16字节，绝大多数路径和参数不含转义，一两次比较即可确认
+        const __m128i percent = _mm_set1_epi8('%');
+        const __m128i plus = _mm_set1_epi8(plusAsSpace ? '+' : '%');
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus));
+            if (_mm_movemask_epi8(hits) != 0) {
+                return true;
+            }
+        }
+#endif
+        for (; p < end; ++p) {
+            if (*p == '%' || (plusAsSpace && *p == '+')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 解码到暂存区并返回结果视图；无需解码或暂存区不足时返回原视图
+    // 非法转义原样保留；%00不解码，避免路径在系统调用处被截断
+    static std::string_view decode(std::string_view text, ScratchArena& arena, bool plusAsSpace) {
+        if (!needsDecoding(text, plusAsSpace)) {
+            return text;
+        }
+        char* out = arena.allocate(text.size());
+        if (out == nullptr) {
+            return text;
+        }
+        size_t length = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (c == '%' && i + 2 < text.size()) {
+                int high = hexValue(text[i + 1]);
+                int low = hexValue(text[i + 2]);
+                if (high >= 0 && low >= 0 && (high | low) != 0) {
+                    out[length++] = static_cast<char>(high << 4 | low);
+                    i += 2;
+                    continue;
+                }
+            } else if (c == '+' && plusAsSpace) {
+                c = ' ';
+            }
+            out[length++] = c;
+        }
+        return std::string_view(out, length);
+    }
+
+private:
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+};
+
+// 查询参数：按'&'和'='切分，键和值都是指向请求缓冲区（或暂存区中解码结果）的视图
+class QueryParams {
+public:
+    void clear() {
+        params.clear();
+    }
+
+    void parse(std::string_view query, ScratchArena& arena) {
+        params.clear();
+        while (!query.empty()) {
+            size_t end = query.find('&');
+            std::string_view pair = query.substr(0, end);
+            query = end == std::string_view::npos ? std::string_view{} : query.substr(end + 1);
+
+            size_t eq = pair.find('=');
+            if (eq == std::string_view::npos) {
+                continue;
+            }
+            params.emplace_back(UrlDecoder::decode(pair.substr(0, eq), arena, true),
+                                UrlDecoder::decode(pair.substr(eq + 1), arena, true));
+        }
+    }
+
+    // 重复的键以最后一个为准，与之前的行为一致；不存在时返回空视图
+    std::string_view get(std::string_view key) const {
+        for (auto it = params.rbegin(); it != params.rend(); ++it) {
+            if (it->first == key) {
+                return it->second;
+            }
+        }
+        return {};
+    }
+
+    const std::vector<std::pair<std::string_view, std::string_view>>& all() const {
+        return params;
+    }
+
+private:
+    // 参数通常只有几个，线性查找比哈希表更快，清空后容量保留，请求之间不再分配
+    std::vector<std::pair<std::string_view, std::string_view>> params;
+};
@@ -8,25 +8,40 @@
 #include <cerrno>
 #include <csignal>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #include "network/AsyncIO.hpp"
 #include "network/NetworkOperation.hpp"
 #include "network/AddrInfoWrapper.hpp"
 #include "network/SocketWrapper.hpp"
 #include "core/Connection.hpp"
+#include "core/Routes.hpp"
+#include "http/FileWatcher.hpp"
+#include "http/CacheWarmer.hpp"
+#include "http/FileLoader.hpp"
 #include "src/core/ConnectionManager.hpp"
 #include "utils/PerformanceMonitor.hpp"
+#include "utils/EventLoopMonitor.hpp"
+#include "utils/AccessLog.hpp"
 
 // 初始化连接协程
 Task g_acceptTask=nullptr;
 
+// 文件监视协程
+Task g_watchTask=nullptr;
+
+// 文件加载完成通知协程
+Task g_loaderTask=nullptr;
+
 // 全局变量，用于控制服务器运行状态
 std::atomic<bool> g_serverRunning = true;
 
 // 信号处理函数
 void signalHandler(int signum) {
     if (signum == SIGINT || signum == SIGTERM) {
-        LOG_INFO(fmt::format("接收到信号 {}, 准备关闭服务器...", signum));
+        LOG_INFO("接收到信号 {}, 准备关闭服务器...", signum);
         g_serverRunning = false;
     }
 }
@@ -72,7 +87,7 @@ SocketWrapper initializeServer(const char* host, const char* port) {
         addrInfo.get()->ai_protocol
     );
     // fmt::print("Socket created with fd: {}\n", sock.get());
-    LOG_INFO(fmt::format("Socket created with fd: {}", sock.get()));
+    LOG_INFO("Socket created with fd: {}", sock.get());
     int reuseaddr = 1;
     if (setsockopt(sock.get(), SOL_SOCKET, SO_REUSEADDR, &reuseaddr, sizeof(reuseaddr)) == -1) {
         throw std::runtime_error("setsockopt failed");
@@ -89,7 +104,7 @@ SocketWrapper initializeServer(const char* host, const char* port) {
         "listen"
     );
     // fmt::print("Socket bound and listening on {}:{}\n", host, port);
-    LOG_INFO(fmt::format("Socket bound and listening on {}:{}", host, port));
+    LOG_INFO("Socket bound and listening on {}:{}", host, port);
     return sock;
 }
 
@@ -131,41 +146,95 @@ Task acceptConnection(int serverFd, int epollFd) {
     }
     co_return;
 }
+// 监视根目录变化并同步更新文件缓存
+Task watchFiles(int epollFd) {
+    auto& watcher = FileWatcher::getInstance();
+    while (g_serverRunning) {
+        co_await ReadableAwaiter(watcher.getFd(), epollFd);
+        watcher.processEvents();
+    }
+    co_return;
+}
+// 接收加载线程的完成通知，恢复等待文件的连接协程
+Task completeFileLoads(int epollFd) {
+    auto& loader = FileLoader::getInstance();
+    while (g_serverRunning) {
+        co_await ReadableAwaiter(loader.getFd(), epollFd);
+        loader.processCompletions();
+    }
+    co_return;
+}
 //事件循环
+// 每次epoll_wait取回的事件数（批次大小）在[最小值, 最大值]之间自适应：
+// 批次被填满说明还有就绪事件在排队，加倍；连续多轮只用到四分之一以下时减半
 void eventLoop(int epollFd) {
-    const int MAX_EVENTS = 10;
-    struct epoll_event events[MAX_EVENTS];
+    auto& config = Config::getInstance();
+    const int MIN_EVENTS = std::max(config.getInt("event_loop_min_events", 16), 1);
+    const int MAX_EVENTS = std::max(config.getInt("event_loop_max_events", 512), MIN_EVENTS);
+    const int SHRINK_AFTER = 64; // 连续多少轮低于四分之一后减半
+    std::vector<struct epoll_event> events(MAX_EVENTS);
+    int batchSize = MIN_EVENTS;
+    int underused = 0;
     
     // 设置超时，以便定期检查服务器是否应该关闭
-    const int TIMEOUT_MS = 100; // 100ms超时，平衡响应性和CPU使用率
+    const int TIMEOUT_MS = std::max(config.getInt("event_loop_timeout_ms", 100), 1);
+    
+    auto& monitor = EventLoopMonitor::getInstance();
+    monitor.startWatchdog(std::chrono::milliseconds(config.getInt("event_loop_watchdog_ms", 500)));
     
     while (g_serverRunning) {
-        int nfds = epoll_wait(epollFd, events, MAX_EVENTS, TIMEOUT_MS);
+        int nfds = epoll_wait(epollFd, events.data(), batchSize, TIMEOUT_MS);
         if (nfds == -1) {
             if (errno == EINTR) continue; // 信号中断，继续
             throw std::runtime_error("epoll_wait failed");
         }
+        monitor.recordWakeup(nfds, batchSize);
+        if (nfds == 0) {
+            continue;
+        }
         
+        auto batchStart = monitor.beginBatch();
         for (int i = 0; i < nfds; ++i) {
             // 如果是协程恢复
             if (events[i].data.ptr != nullptr) {
                 // 恢复协程
+                auto resumeStart = monitor.beginResume(batchStart);
                 std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+                monitor.endResume(resumeStart);
+            }
+        }
+        monitor.recordBatch(batchStart, std::chrono::steady_clock::now());
+        
+        // 移除本轮中关闭的连接（连接协程已结束，可以安全销毁）
+        ConnectionManager::getInstance().executePendingTasks();
+        
+        // 调整批次大小
+        if (nfds == batchSize && batchSize < MAX_EVENTS) {
+            batchSize = std::min(batchSize * 2, MAX_EVENTS);
+            underused = 0;
+        } else if (nfds * 4 < batchSize && batchSize > MIN_EVENTS) {
+            if (++underused >= SHRINK_AFTER) {
+                batchSize = std::max(batchSize / 2, MIN_EVENTS);
+                underused = 0;
             }
+        } else {
+            underused = 0;
         }
     }
+    monitor.stopWatchdog();
     
     // 关闭程序
     LOG_INFO("开始进行服务器关闭...");
     
     // 1. 停止接受新连接 (g_acceptTask会在下一次co_await时自动结束)
-    // 2. 记录现有活动连接数
+    // 2. 移除最后一轮中关闭的连接，记录现有活动连接数
+    ConnectionManager::getInstance().executePendingTasks();
     size_t activeConnections = ConnectionManager::getInstance().getActiveConnectionCount();
-    LOG_INFO(fmt::format("当前活动连接数: {}", activeConnections));
+    LOG_INFO("当前活动连接数: {}", activeConnections);
     
     // 3. 给所有连接一定时间完成当前请求
     const int GRACEFUL_TIMEOUT_SEC = 3;
-    LOG_INFO(fmt::format("等待 {} 秒让现有连接完成...", GRACEFUL_TIMEOUT_SEC));
+    LOG_INFO("等待 {} 秒让现有连接完成...", GRACEFUL_TIMEOUT_SEC);
     
     // 等待一段时间或者直到所有连接都关闭
     time_t startTime = time(nullptr);
@@ -185,17 +254,20 @@ void eventLoop(int epollFd) {
 }
 void runServer(const std::string& host, const std::string& port, const std::string& rootDir) {
     // 初始化服务器
-    LOG_INFO(fmt::format("初始化服务器 {}:{}", host, port));
+    LOG_INFO("初始化服务器 {}:{}", host, port);
     SocketWrapper serverSocket = initializeServer(host.c_str(), port.c_str());
     setNonBlocking(serverSocket.get());
     
     // 初始化文件服务
-    LOG_INFO(fmt::format("初始化文件服务，根目录: {}", rootDir));
+    LOG_INFO("初始化文件服务，根目录: {}", rootDir);
     if (!FileService::getInstance().init(rootDir)) {
         LOG_FATAL("文件服务初始化失败");
         throw std::runtime_error("文件服务初始化失败");
     }
     
+    // 注册路由，处理函数在启动后只读
+    Routes::registerAll(Router::getInstance());
+    
     // 创建 epoll 实例
     int epollFd = createEpoll();
     LOG_INFO("创建epoll实例成功");
@@ -204,10 +276,36 @@ void runServer(const std::string& host, const std::string& port, const std::stri
     g_acceptTask = acceptConnection(serverSocket.get(), epollFd);
     LOG_INFO("创建accept协程任务成功");
     
+    // 启动文件监视，根目录内容变化时自动失效或刷新缓存
+    if (Config::getInstance().getBool("enable_file_watch", true) && FileWatcher::getInstance().init(rootDir)) {
+        g_watchTask = watchFiles(epollFd);
+        LOG_INFO("创建文件监视协程任务成功");
+    }
+    
+    // 启动文件加载线程，缓存未命中的文件在后台读取，同一文件的并发未命中只读取一次
+    if (FileLoader::getInstance().init(std::max(Config::getInstance().getInt("file_loader_threads", 2), 0))) {
+        g_loaderTask = completeFileLoads(epollFd);
+    }
+    
+    // 二进制访问日志：每个请求一条定长记录，写入mmap映射的分段文件
+    if (Config::getInstance().getBool("access_log", false)) {
+        AccessLog::getInstance().init(Config::getInstance().getString("access_log_dir", "access_logs"),
+            static_cast<size_t>(std::max(Config::getInstance().getInt("access_log_segment_mb", 64), 1)) << 20,
+            std::max(Config::getInstance().getInt("access_log_max_segments", 16), 0));
+    }
+    
+    // 后台预热文件缓存，预热期间照常处理请求
+    CacheWarmer::getInstance().start();
+    
     // 开始事件循环
     LOG_INFO("开始事件循环");
     eventLoop(epollFd);
 
+    // 停止预热并保存热点清单
+    CacheWarmer::getInstance().stop();
+    FileLoader::getInstance().stop();
+    AccessLog::getInstance().close();
+
     // 关闭服务器
     close(epollFd);
     close(serverSocket.get());
@@ -218,6 +316,7 @@ int main() {
         // 设置信号处理
         signal(SIGINT, signalHandler);  // 处理Ctrl+C
         signal(SIGTERM, signalHandler); // 处理terminate信号
+        signal(SIGPIPE, SIG_IGN);       // sendfile没有MSG_NOSIGNAL，对端关闭时改为返回EPIPE
         
         // 设置中文
         setlocale(LC_ALL, "zh_CN.UTF-8");
@@ -247,9 +346,20 @@ int main() {
             }
         }
         
+        // 异步日志：请求线程只把记录放入本线程的缓冲区，由后台线程批量写出
+        if (Config::getInstance().getBool("log_async", false)) {
+            Logger::getInstance().startAsync(
+                std::max(Config::getInstance().getInt("log_buffer_size", 8192), 0),
+                std::chrono::milliseconds(Config::getInstance().getInt("log_flush_interval_ms", 100)),
+                Config::getInstance().getString("log_overflow", "drop") == "block"
+                    ? Logger::OverflowPolicy::Block : Logger::OverflowPolicy::Drop);
+        }
+        
         // 设置性能监控
         bool enablePerformanceMonitoring = Config::getInstance().getBool("enable_performance_monitoring", false);
         PerformanceMonitor::getInstance().setEnabled(enablePerformanceMonitoring);
+        EventLoopMonitor::getInstance().setEnabled(enablePerformanceMonitoring);
+        ConnectionManager::getInstance().setStatsEnabled(Config::getInstance().getBool("connection_stats", false));
         
         // 获取服务器配置
         std::string host = Config::getInstance().getString("host", "127.0.0.1");
@@ -260,7 +370,7 @@ int main() {
         LOG_INFO("服务器正在启动...");
         runServer(host, port, rootDir);
     } catch (const std::exception& e) {
-        LOG_FATAL(fmt::format("服务器启动失败: {}", e.what()));
+        LOG_FATAL("服务器启动失败: {}", e.what());
         fmt::print("错误: {}\n", e.what());
         return EXIT_FAILURE;
     }
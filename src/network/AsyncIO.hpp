@@ -3,6 +3,8 @@
 #include <coroutine>
 #include <fmt/format.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <chrono>
 #include <unistd.h>
 #include <cerrno>
 // 用于异步 accept 的 awaiter
@@ -71,3 +73,112 @@ public:
     }
 };
 
+
+// 等待任意文件描述符可读的 awaiter（用于inotify、eventfd等非套接字fd）
+class ReadableAwaiter {
+private:
+    int fd;
+    int epollFd;
+
+public:
+    ReadableAwaiter(int fd, int epollFd) : fd(fd), epollFd(epollFd) {}
+
+    // 总是挂起，由调用方在恢复后读取直到EAGAIN
+    bool await_ready() { return false; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+        ev.data.ptr = h.address();
+
+        // 重新布防时内核会重新检查就绪状态，不会丢失期间到达的事件
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+            if (errno == ENOENT) {
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+                    throw std::runtime_error(fmt::format("epoll_ctl ADD failed in ReadableAwaiter: {}", strerror(errno)));
+                }
+            } else {
+                throw std::runtime_error(fmt::format("epoll_ctl MOD failed in ReadableAwaiter: {}", strerror(errno)));
+            }
+        }
+    }
+
+    void await_resume() {}
+};
+
+// 等待套接字可写的 awaiter，总是挂起；已可写的套接字在下一次epoll_wait中立即返回，
+// 因此也用于让出事件循环，让同一批次中其他就绪的连接先得到处理
+class WritableAwaiter {
+private:
+    int fd;
+    int epollFd;
+
+public:
+    WritableAwaiter(int fd, int epollFd) : fd(fd), epollFd(epollFd) {}
+
+    bool await_ready() { return false; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        struct epoll_event ev;
+        ev.events = EPOLLOUT | EPOLLET | EPOLLONESHOT;
+        ev.data.ptr = h.address();
+
+        // 重新布防时内核会重新检查就绪状态，已可写时立即产生事件
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+            if (errno == ENOENT) {
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+                    throw std::runtime_error(fmt::format("epoll_ctl ADD failed in WritableAwaiter: {}", strerror(errno)));
+                }
+            } else {
+                throw std::runtime_error(fmt::format("epoll_ctl MOD failed in WritableAwaiter: {}", strerror(errno)));
+            }
+        }
+    }
+
+    void await_resume() {}
+};
+
+// 挂起协程一段时间的 awaiter：到期时由事件循环恢复，等待期间事件循环照常处理其他事件
+// 每次等待使用一个临时的timerfd，awaiter析构时关闭（关闭后自动从epoll中移除）
+class SleepAwaiter {
+private:
+    std::chrono::milliseconds duration;
+    int epollFd;
+    int timerFd = -1;
+
+public:
+    SleepAwaiter(std::chrono::milliseconds duration, int epollFd) : duration(duration), epollFd(epollFd) {}
+
+    ~SleepAwaiter() {
+        if (timerFd != -1) {
+            ::close(timerFd);
+        }
+    }
+
+    SleepAwaiter(const SleepAwaiter&) = delete;
+    SleepAwaiter& operator=(const SleepAwaiter&) = delete;
+
+    bool await_ready() { return duration.count() <= 0; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerFd == -1) {
+            throw std::runtime_error(fmt::format("timerfd_create failed in SleepAwaiter: {}", strerror(errno)));
+        }
+        struct itimerspec spec{};
+        spec.it_value.tv_sec = duration.count() / 1000;
+        spec.it_value.tv_nsec = duration.count() % 1000 * 1000000;
+        if (timerfd_settime(timerFd, 0, &spec, nullptr) == -1) {
+            throw std::runtime_error(fmt::format("timerfd_settime failed in SleepAwaiter: {}", strerror(errno)));
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = h.address();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev) == -1) {
+            throw std::runtime_error(fmt::format("epoll_ctl ADD failed in SleepAwaiter: {}", strerror(errno)));
+        }
+    }
+
+    void await_resume() {}
+};
@@ -0,0 +1,392 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+#include "RequestTimeline.hpp"
+
+// 二进制访问日志：每个请求一条64字节的定长记录，写入mmap映射的分段文件，写满后轮换
+// 路径按段内编号记录，首次出现时在记录之前写入一条路径定义，每个段可以单独解码
+// 只在事件循环线程中写入；后台线程提前为即将写入的页面建立可写映射，写入时不触发缺页
+// 解码工具见tools/AccessLogDecoder.cpp
+class AccessLog {
+public:
+    static constexpr char MAGIC[8] = {'H', 'W', 'S', 'A', 'L', 'O', 'G', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t SLOT_SIZE = 64;
+
+    // 文件格式：Header | 槽位(64字节)...，类型为0的槽位表示段结束（文件预先以0填充）
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t slotSize;
+        uint64_t sequence;      // 段序号
+        uint64_t startTime;     // 段创建时间（Unix纳秒）
+        uint8_t reserved[32];
+    };
+
+    enum SlotType : uint8_t {
+        SLOT_END = 0,
+        SLOT_REQUEST = 1,
+        SLOT_PATH = 2,
+    };
+
+    enum Method : uint8_t {
+        METHOD_OTHER, METHOD_GET, METHOD_HEAD, METHOD_POST, METHOD_PUT, METHOD_DELETE, METHOD_OPTIONS, METHOD_PATCH,
+    };
+
+    static constexpr std::string_view METHOD_NAMES[] = {"OTHER", "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH"};
+
+    static constexpr uint32_t UNKNOWN_PATH = 0xFFFFFFFF; // 段内路径数达到上限后的请求不记录路径
+    static constexpr uint8_t FLAG_KEEP_ALIVE = 1;
+
+    // 一个请求；耗时单位为微秒，addr按网络字节序存放（IPv4只用前4字节）
+    struct Record {
+        uint8_t type;
+        uint8_t method;
+        uint8_t family;         // 4、6，或0表示未知
+        uint8_t flags;
+        uint16_t status;
+        uint16_t port;
+        uint64_t timestamp;     // 收到请求第一个字节的时间（Unix纳秒）
+        uint64_t bytesSent;
+        uint32_t pathId;
+        uint32_t bytesReceived;
+        uint32_t totalMicros;   // 收到第一个字节到发出最后一个字节
+        uint32_t headerReadMicros;
+        uint32_t handlerMicros;
+        uint32_t writeMicros;
+        uint8_t addr[16];
+    };
+
+    // 路径定义：路径内容从text开始，超出本槽位的部分占用随后的槽位
+    struct PathRecord {
+        uint8_t type;
+        uint8_t reserved;
+        uint16_t length;
+        uint32_t pathId;
+        char text[SLOT_SIZE - 8];
+    };
+
+    static_assert(sizeof(Header) == SLOT_SIZE && sizeof(Record) == SLOT_SIZE && sizeof(PathRecord) == SLOT_SIZE);
+
+    static constexpr size_t MAX_PATH_LENGTH = 1024;   // 更长的路径截断
+    static constexpr size_t MAX_PATHS = 65536;        // 每个段最多登记的路径数
+    static constexpr size_t PREFAULT_BYTES = 256 * 1024; // 每次预先建立可写映射的大小
+
+    // 路径定义占用的槽位数
+    static size_t pathSlots(size_t length) {
+        return (offsetof(PathRecord, text) + length + SLOT_SIZE - 1) / SLOT_SIZE;
+    }
+
+    static AccessLog& getInstance() {
+        static AccessLog instance;
+        return instance;
+    }
+
+    // 在directory下创建分段文件access-<序号>.bin，序号接着目录中已有的段；maxSegments为0时不删除旧段
+    bool init(const std::string& directory, size_t segmentBytes, size_t maxSegments) {
+        this->directory = directory;
+        this->segmentBytes = std::max(segmentBytes / SLOT_SIZE * SLOT_SIZE, SLOT_SIZE * 64);
+        this->maxSegments = maxSegments;
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        std::vector<std::pair<uint64_t, std::string>> existing;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            uint64_t sequence;
+            if (parseSegmentName(entry.path().filename().string(), sequence)) {
+                existing.emplace_back(sequence, entry.path().string());
+            }
+        }
+        std::sort(existing.begin(), existing.end());
+        for (auto& [sequence, path] : existing) {
+            segments.push_back(std::move(path));
+            nextSequence = sequence + 1;
+        }
+        if (!openSegment()) {
+            return false;
+        }
+        prefaultThread = std::thread([this] { runPrefault(); });
+        LOG_INFO("访问日志已启动: {} (每段 {}MB, 保留 {} 段)", directory, this->segmentBytes >> 20, maxSegments);
+        return true;
+    }
+
+    bool isEnabled() const {
+        return data != nullptr;
+    }
+
+    // 记录一个请求
+    void log(std::string_view method, std::string_view path, int status, bool keepAlive,
+             const sockaddr_storage& peer, const RequestTimeline& timeline) {
+        if (data == nullptr) return;
+
+        path = path.substr(0, MAX_PATH_LENGTH);
+        auto it = paths.find(path);
+        bool define = it == paths.end() && paths.size() < MAX_PATHS;
+        // 路径定义和请求记录要在同一个段内；轮换后新段的路径表为空，需要重新定义
+        if (offset + (1 + (define ? pathSlots(path.size()) : 0)) * SLOT_SIZE > length) {
+            closeSegment();
+            if (!openSegment()) return;
+            it = paths.end();
+            define = true;
+        }
+        uint32_t pathId = it != paths.end() ? it->second : define ? definePath(path) : UNKNOWN_PATH;
+
+        Record* record = reinterpret_cast<Record*>(data + offset);
+        offset += SLOT_SIZE;
+        record->method = methodOf(method);
+        record->flags = keepAlive ? FLAG_KEEP_ALIVE : 0;
+        record->status = static_cast<uint16_t>(status);
+        record->pathId = pathId;
+        record->bytesSent = timeline.bytesSent;
+        record->bytesReceived = static_cast<uint32_t>(std::min<uint64_t>(timeline.bytesReceived, UINT32_MAX));
+        auto start = timeline.firstByte != RequestTimeline::Clock::time_point{} ? timeline.firstByte : timeline.headersParsed;
+        auto end = timeline.lastByteSent != RequestTimeline::Clock::time_point{} ? timeline.lastByteSent
+                                                                                  : RequestTimeline::Clock::now();
+        // 时间线使用steady_clock，换算为墙钟时间
+        record->timestamp = wallClockOffset + RequestTimeline::nanosBetween(RequestTimeline::Clock::time_point{}, start);
+        record->totalMicros = micros(start, end);
+        record->headerReadMicros = micros(timeline.firstByte, timeline.headersParsed);
+        record->handlerMicros = micros(timeline.handlerStart, timeline.handlerEnd);
+        record->writeMicros = micros(timeline.firstByteSent, timeline.lastByteSent);
+        setAddress(*record, peer);
+        // 类型最后写入，进程崩溃时解码工具不会读到写了一半的记录
+        std::atomic_signal_fence(std::memory_order_release);
+        record->type = SLOT_REQUEST;
+        ++records;
+        if (offset + PREFAULT_BYTES > requested.load(std::memory_order_relaxed)) {
+            requestPrefault();
+        }
+    }
+
+    uint64_t getRecordCount() const {
+        return records;
+    }
+
+    // 结束当前段（截掉未使用的部分）并停止记录
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(prefaultMutex);
+            stopping = true;
+        }
+        prefaultCondition.notify_one();
+        if (prefaultThread.joinable()) {
+            prefaultThread.join();
+        }
+        closeSegment();
+    }
+
+    ~AccessLog() {
+        close();
+    }
+
+    // 段文件名：access-<序号>.bin
+    static bool parseSegmentName(const std::string& name, uint64_t& sequence) {
+        if (name.size() <= 11 || name.rfind("access-", 0) != 0 || name.compare(name.size() - 4, 4, ".bin") != 0) {
+            return false;
+        }
+        std::string digits = name.substr(7, name.size() - 11);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        sequence = std::stoull(digits);
+        return true;
+    }
+
+private:
+    AccessLog() = default;
+
+    // 删除复制和移动构造/赋值
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+    AccessLog(AccessLog&&) = delete;
+    AccessLog& operator=(AccessLog&&) = delete;
+
+    // 按string_view查找，不为查找构造std::string
+    struct PathHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view value) const {
+            return std::hash<std::string_view>{}(value);
+        }
+    };
+
+    static uint8_t methodOf(std::string_view method) {
+        for (size_t i = 1; i < std::size(METHOD_NAMES); ++i) {
+            if (METHOD_NAMES[i] == method) {
+                return static_cast<uint8_t>(i);
+            }
+        }
+        return METHOD_OTHER;
+    }
+
+    static uint32_t micros(RequestTimeline::Clock::time_point from, RequestTimeline::Clock::time_point to) {
+        if (from == RequestTimeline::Clock::time_point{} || to == RequestTimeline::Clock::time_point{}) {
+            return 0;
+        }
+        return static_cast<uint32_t>(std::min<uint64_t>(RequestTimeline::nanosBetween(from, to) / 1000, UINT32_MAX));
+    }
+
+    static void setAddress(Record& record, const sockaddr_storage& peer) {
+        if (peer.ss_family == AF_INET) {
+            const auto& in = reinterpret_cast<const sockaddr_in&>(peer);
+            record.family = 4;
+            record.port = ntohs(in.sin_port);
+            std::memcpy(record.addr, &in.sin_addr, sizeof(in.sin_addr));
+        } else if (peer.ss_family == AF_INET6) {
+            const auto& in6 = reinterpret_cast<const sockaddr_in6&>(peer);
+            record.family = 6;
+            record.port = ntohs(in6.sin6_port);
+            std::memcpy(record.addr, &in6.sin6_addr, sizeof(in6.sin6_addr));
+        }
+    }
+
+    uint32_t definePath(std::string_view path) {
+        uint32_t pathId = static_cast<uint32_t>(paths.size());
+        PathRecord* record = reinterpret_cast<PathRecord*>(data + offset);
+        record->length = static_cast<uint16_t>(path.size());
+        record->pathId = pathId;
+        std::memcpy(record->text, path.data(), path.size());
+        offset += pathSlots(path.size()) * SLOT_SIZE;
+        std::atomic_signal_fence(std::memory_order_release);
+        record->type = SLOT_PATH;
+        paths.emplace(std::string(path), pathId);
+        return pathId;
+    }
+
+    bool openSegment() {
+        std::string path = fmt::format("{}/access-{:06}.bin", directory, nextSequence);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            LOG_ERROR("无法创建访问日志段 {}: {}", path, strerror(errno));
+            return false;
+        }
+        void* mapped = MAP_FAILED;
+        if (::ftruncate(fd, segmentBytes) == 0) {
+            mapped = ::mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("无法映射访问日志段 {}: {}", path, strerror(errno));
+            ::close(fd);
+            ::unlink(path.c_str());
+            return false;
+        }
+
+        segmentFd = fd;
+        {
+            std::lock_guard<std::mutex> lock(prefaultMutex);
+            data = static_cast<char*>(mapped);
+            length = segmentBytes;
+        }
+        paths.clear();
+
+        auto wallNow = std::chrono::system_clock::now();
+        auto steadyNow = RequestTimeline::Clock::now();
+        uint64_t wallNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(wallNow.time_since_epoch()).count();
+        wallClockOffset = wallNanos - RequestTimeline::nanosBetween(RequestTimeline::Clock::time_point{}, steadyNow);
+
+        Header* header = reinterpret_cast<Header*>(data);
+        std::copy(std::begin(MAGIC), std::end(MAGIC), header->magic);
+        header->version = VERSION;
+        header->slotSize = SLOT_SIZE;
+        header->sequence = nextSequence;
+        header->startTime = wallNanos;
+        offset = sizeof(Header);
+        requestPrefault();
+
+        ++nextSequence;
+        segments.push_back(path);
+        removeOldSegments();
+        return true;
+    }
+
+    // 请求后台线程为当前写入位置之后的两块建立可写映射（每写过一块请求一次）
+    // 不加锁，后台线程正在建立映射时写入线程不等待；错过的唤醒由下一次请求补上
+    void requestPrefault() {
+        requested.store(std::min(offset + 2 * PREFAULT_BYTES, length), std::memory_order_relaxed);
+        prefaultCondition.notify_one();
+    }
+
+    // 后台线程：逐块建立可写映射（文件映射的首次写入要分配页缓存并经过page_mkwrite）
+    // 内核不支持MADV_POPULATE_WRITE时不做任何事，写入时照常缺页
+    void runPrefault() {
+        std::unique_lock<std::mutex> lock(prefaultMutex);
+        while (true) {
+            prefaultCondition.wait(lock, [this] {
+                return stopping || (data != nullptr && populated < requested.load(std::memory_order_relaxed));
+            });
+            if (stopping) {
+                break;
+            }
+            size_t end = std::min(populated + PREFAULT_BYTES, requested.load(std::memory_order_relaxed));
+#ifdef MADV_POPULATE_WRITE
+            // 持锁进行，轮换段时等待当前这一块完成后再解除映射
+            ::madvise(data + populated, end - populated, MADV_POPULATE_WRITE);
+#endif
+            populated = end;
+        }
+    }
+
+    void closeSegment() {
+        if (data == nullptr) return;
+        std::lock_guard<std::mutex> lock(prefaultMutex);
+        ::munmap(data, length);
+        if (::ftruncate(segmentFd, offset) != 0) {
+            LOG_WARNING("无法截断访问日志段: {}", strerror(errno));
+        }
+        ::close(segmentFd);
+        data = nullptr;
+        segmentFd = -1;
+        populated = 0;
+        requested.store(0, std::memory_order_relaxed);
+    }
+
+    void removeOldSegments() {
+        while (maxSegments > 0 && segments.size() > maxSegments) {
+            ::unlink(segments.front().c_str());
+            segments.pop_front();
+        }
+    }
+
+    std::string directory;
+    size_t segmentBytes{64 << 20};
+    size_t maxSegments{0};
+    std::deque<std::string> segments;   // 现存的段，从旧到新
+    uint64_t nextSequence{0};
+
+    int segmentFd{-1};
+    char* data{nullptr};
+    size_t length{0};
+    size_t offset{0};
+
+    // 预先建立映射：requested由写入线程设置，populated由后台线程推进（在prefaultMutex下访问）
+    std::mutex prefaultMutex;
+    std::condition_variable prefaultCondition;
+    std::atomic<size_t> requested{0};
+    size_t populated{0};
+    bool stopping{false};
+    std::thread prefaultThread;
+    uint64_t wallClockOffset{0};   // 墙钟时间与steady_clock的差（纳秒），每段开始时校准
+    uint64_t records{0};
+    std::unordered_map<std::string, uint32_t, PathHash, std::equal_to<>> paths;  // 当前段的路径编号
+};
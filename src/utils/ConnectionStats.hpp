@@ -0,0 +1,246 @@
+#pragma once
+
+#include <sys/types.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include "../network/SocketAddressStorage.hpp"
+
+// 单个连接的统计：收发字节、完成的请求数、读写系统调用次数、挂起等待可读/可写的时间和当前状态
+// 连接及其统计只在事件循环线程中读写，不需要原子操作
+struct ConnectionStats {
+    using Clock = std::chrono::steady_clock;
+
+    enum State : uint8_t {
+        Idle,            // 等待下一个请求（keep-alive空闲或刚建立）
+        ReadingHeaders,  // 已收到请求的第一个字节，请求尚未读完
+        Handling,        // 处理函数执行中（含等待文件加载）
+        Writing,         // 发送响应
+        STATE_COUNT
+    };
+
+    static constexpr std::array<std::string_view, STATE_COUNT> STATE_NAMES = {
+        "idle", "reading", "handling", "writing"};
+
+    Clock::time_point established = Clock::now();
+    Clock::time_point stateSince = established;
+    Clock::time_point waitingSince{};  // 当前这次挂起等待的开始时间，未挂起时为空
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t requests = 0;
+    uint64_t readCalls = 0;
+    uint64_t writeCalls = 0;
+    uint64_t readWaitNanos = 0;   // 请求读到一半时等待可读的时间
+    uint64_t writeWaitNanos = 0;  // 发送缓冲区满时等待可写的时间，慢客户端体现在这里
+    uint64_t idleNanos = 0;       // 两个请求之间等待的时间
+    std::string_view route;       // 当前或最近一个请求匹配的路由模式（由Router持有）
+    State state = Idle;
+
+    void setState(State next) {
+        if (state != next) {
+            state = next;
+            stateSince = Clock::now();
+        }
+    }
+
+    // 每次read调用后记录，bytes为返回值；空闲时收到数据即进入读取请求状态
+    void recordRead(ssize_t bytes) {
+        ++readCalls;
+        if (bytes > 0) {
+            bytesIn += bytes;
+            if (state == Idle) {
+                setState(ReadingHeaders);
+            }
+        }
+    }
+
+    // 每次sendmsg/sendfile调用后记录，bytes为返回值
+    void recordWrite(ssize_t bytes) {
+        ++writeCalls;
+        if (bytes > 0) {
+            bytesOut += bytes;
+        }
+    }
+
+    // 挂起等待socket可读或可写前后调用，等待时间按挂起时的状态归类
+    void beginWait() {
+        waitingSince = Clock::now();
+    }
+
+    void endWait() {
+        if (waitingSince == Clock::time_point{}) {
+            return;
+        }
+        if (uint64_t* bucket = waitBucket(state)) {
+            *bucket += nanosBetween(waitingSince, Clock::now());
+        }
+        waitingSince = {};
+    }
+
+    // 截至now的等待时间，包括仍在进行中的这次等待
+    uint64_t waitNanos(State bucketState, Clock::time_point now) const {
+        uint64_t total = bucketState == ReadingHeaders ? readWaitNanos
+                       : bucketState == Writing        ? writeWaitNanos
+                                                       : idleNanos;
+        if (waitingSince != Clock::time_point{} && state == bucketState) {
+            total += nanosBetween(waitingSince, now);
+        }
+        return total;
+    }
+
+    static uint64_t nanosBetween(Clock::time_point from, Clock::time_point to) {
+        return to > from ? std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count() : 0;
+    }
+
+private:
+    uint64_t* waitBucket(State bucketState) {
+        switch (bucketState) {
+            case Idle: return &idleNanos;
+            case ReadingHeaders: return &readWaitNanos;
+            case Writing: return &writeWaitNanos;
+            default: return nullptr;
+        }
+    }
+};
+
+// 连接表：某一时刻全部连接的统计快照，按指定字段降序取前N个，输出文本表格或JSON
+class ConnectionTable {
+public:
+    struct Entry {
+        int fd;
+        SocketAddressStorage peer;
+        ConnectionStats stats;
+    };
+
+    static constexpr std::string_view DEFAULT_SORT = "bytes_out";
+
+    // 可排序的字段，sortKey不在其中时返回false
+    static bool isSortKey(std::string_view sortKey) {
+        return findField(sortKey) != nullptr;
+    }
+
+    static std::string sortKeys() {
+        std::string keys;
+        for (const auto& field : FIELDS) {
+            if (!keys.empty()) {
+                keys += ", ";
+            }
+            keys += field.name;
+        }
+        return keys;
+    }
+
+    static std::string render(std::vector<Entry>& entries, std::string_view sortKey, size_t limit, bool json) {
+        const Field* field = findField(sortKey);
+        if (field == nullptr) {
+            field = findField(DEFAULT_SORT);
+        }
+        auto now = ConnectionStats::Clock::now();
+        size_t total = entries.size();
+        size_t shown = std::min(limit, total);
+        std::partial_sort(entries.begin(), entries.begin() + shown, entries.end(),
+            [&](const Entry& a, const Entry& b) { return field->value(a.stats, now) > field->value(b.stats, now); });
+
+        std::array<size_t, ConnectionStats::STATE_COUNT> states{};
+        for (const auto& entry : entries) {
+            ++states[entry.stats.state];
+        }
+
+        std::string out;
+        auto it = std::back_inserter(out);
+        if (json) {
+            fmt::format_to(it, "{{\"total\":{},\"sort\":\"{}\",\"states\":{{", total, field->name);
+            for (size_t i = 0; i < states.size(); ++i) {
+                fmt::format_to(it, "{}\"{}\":{}", i ? "," : "", ConnectionStats::STATE_NAMES[i], states[i]);
+            }
+            out += "},\"connections\":[";
+            for (size_t i = 0; i < shown; ++i) {
+                const Entry& entry = entries[i];
+                const ConnectionStats& stats = entry.stats;
+                fmt::format_to(it, "{}{{\"fd\":{},\"peer\":\"{}\",\"state\":\"{}\",\"route\":\"{}\"",
+                    i ? "," : "", entry.fd, entry.peer.to_string(), ConnectionStats::STATE_NAMES[stats.state],
+                    stats.route);
+                for (const auto& column : FIELDS) {
+                    fmt::format_to(it, ",\"{}\":{}", column.jsonName, column.value(stats, now) / column.jsonDivisor);
+                }
+                out += '}';
+            }
+            out += "]}";
+            return out;
+        }
+
+        fmt::format_to(it, "连接: {} 个 (", total);
+        for (size_t i = 0; i < states.size(); ++i) {
+            fmt::format_to(it, "{}{} {}", i ? ", " : "", ConnectionStats::STATE_NAMES[i], states[i]);
+        }
+        fmt::format_to(it, "), 按 {} 降序显示前 {} 个\n", field->name, shown);
+        fmt::format_to(it, "{:>5} {:<22} {:<9} {:>9} {:>9} {:>12} {:>12} {:>8} {:>7} {:>7} {:>10} {:>10} {:>10}  {}\n",
+            "fd", "peer", "state", "age", "in_state", "bytes_in", "bytes_out", "requests", "reads", "writes",
+            "read_wait", "write_wait", "idle", "route");
+        for (size_t i = 0; i < shown; ++i) {
+            const Entry& entry = entries[i];
+            const ConnectionStats& stats = entry.stats;
+            fmt::format_to(it,
+                "{:>5} {:<22} {:<9} {:>8.1f}s {:>8.1f}s {:>12} {:>12} {:>8} {:>7} {:>7} {:>8.1f}ms {:>8.1f}ms {:>9.1f}s  {}\n",
+                entry.fd, entry.peer.to_string(), ConnectionStats::STATE_NAMES[stats.state],
+                ConnectionStats::nanosBetween(stats.established, now) / 1e9,
+                ConnectionStats::nanosBetween(stats.stateSince, now) / 1e9, stats.bytesIn, stats.bytesOut,
+                stats.requests, stats.readCalls, stats.writeCalls,
+                stats.waitNanos(ConnectionStats::ReadingHeaders, now) / 1e6,
+                stats.waitNanos(ConnectionStats::Writing, now) / 1e6,
+                stats.waitNanos(ConnectionStats::Idle, now) / 1e9, stats.route.empty() ? "-" : stats.route);
+        }
+        return out;
+    }
+
+private:
+    struct Field {
+        std::string_view name;      // 排序参数
+        std::string_view jsonName;  // JSON中的字段名
+        uint64_t jsonDivisor;       // 纳秒换算为JSON中的单位
+        uint64_t (*value)(const ConnectionStats&, ConnectionStats::Clock::time_point);
+    };
+
+    static constexpr Field FIELDS[] = {
+        {"age", "age_us", 1000,
+         [](const ConnectionStats& s, ConnectionStats::Clock::time_point now) {
+             return ConnectionStats::nanosBetween(s.established, now);
+         }},
+        {"bytes_in", "bytes_in", 1, [](const ConnectionStats& s, ConnectionStats::Clock::time_point) { return s.bytesIn; }},
+        {"bytes_out", "bytes_out", 1, [](const ConnectionStats& s, ConnectionStats::Clock::time_point) { return s.bytesOut; }},
+        {"requests", "requests", 1, [](const ConnectionStats& s, ConnectionStats::Clock::time_point) { return s.requests; }},
+        {"reads", "reads", 1, [](const ConnectionStats& s, ConnectionStats::Clock::time_point) { return s.readCalls; }},
+        {"writes", "writes", 1, [](const ConnectionStats& s, ConnectionStats::Clock::time_point) { return s.writeCalls; }},
+        {"read_wait", "read_wait_us", 1000,
+         [](const ConnectionStats& s, ConnectionStats::Clock::time_point now) {
+             return s.waitNanos(ConnectionStats::ReadingHeaders, now);
+         }},
+        {"write_wait", "write_wait_us", 1000,
+         [](const ConnectionStats& s, ConnectionStats::Clock::time_point now) {
+             return s.waitNanos(ConnectionStats::Writing, now);
+         }},
+        {"idle", "idle_us", 1000,
+         [](const ConnectionStats& s, ConnectionStats::Clock::time_point now) {
+             return s.waitNanos(ConnectionStats::Idle, now);
+         }},
+        {"state", "state_us", 1000,
+         [](const ConnectionStats& s, ConnectionStats::Clock::time_point now) {
+             return ConnectionStats::nanosBetween(s.stateSince, now);
+         }},
+    };
+
+    static const Field* findField(std::string_view name) {
+        for (const auto& field : FIELDS) {
+            if (field.name == name) {
+                return &field;
+            }
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+#include "LatencyHistogram.hpp"
+
+// 事件循环监控：由事件循环线程写入（单写者，relaxed原子操作），其他线程随时读取
+// - 每次唤醒：epoll_wait返回的事件数、空唤醒（超时）和批次被填满的次数
+// - 每轮处理时间：epoll_wait返回后处理完这一批事件所用的时间
+// - 调度延迟：事件就绪（epoll_wait返回）到对应协程被恢复的时间
+// - 单次恢复耗时：最长的一次及其所服务的路由
+// 看门狗线程定期检查事件循环是否卡在某一轮中，超过阈值时告警
+class EventLoopMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static EventLoopMonitor& getInstance() {
+        static EventLoopMonitor instance;
+        return instance;
+    }
+
+    void setEnabled(bool enabled) {
+        this->enabled = enabled;
+    }
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    // 记录一次唤醒，capacity为本次epoll_wait的批次大小
+    void recordWakeup(size_t events, size_t capacity) {
+        batchCapacity.store(capacity, std::memory_order_relaxed);
+        if (!enabled) return;
+
+        increment(wakeups);
+        if (events == 0) {
+            increment(idleWakeups);
+            return;
+        }
+        if (events == capacity) {
+            increment(fullWakeups);
+        }
+        batchSizes.record(events, epochSeconds(Clock::now()));
+    }
+
+    // 一轮处理开始，看门狗从这里开始计时
+    Clock::time_point beginBatch() {
+        auto now = Clock::now();
+        busySince.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        return now;
+    }
+
+    // 一轮处理结束，start为beginBatch的返回值
+    void recordBatch(Clock::time_point start, Clock::time_point end) {
+        busySince.store(0, std::memory_order_relaxed);
+        if (!enabled) return;
+
+        iterations.record(micros(start, end), epochSeconds(end));
+    }
+
+    // 恢复一个协程之前调用，记录从事件就绪到恢复的调度延迟，返回恢复开始的时间
+    Clock::time_point beginResume(Clock::time_point batchStart) {
+        auto now = Clock::now();
+        currentRoute = {};
+        if (enabled) {
+            lag.record(micros(batchStart, now), epochSeconds(now));
+            increment(resumes);
+        }
+        return now;
+    }
+
+    // 协程恢复后再次挂起（或结束）时调用，更新最长的单次恢复
+    void endResume(Clock::time_point resumeStart) {
+        if (!enabled && stallThreshold.count() == 0) return;
+
+        auto now = Clock::now();
+        uint64_t duration = micros(resumeStart, now);
+        std::string_view route = currentRoute.empty() ? OTHER_ROUTE : currentRoute;
+        if (enabled && duration > longestResumeMicros.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(longestMutex);
+            longestResumeRoute.assign(route);
+            longestResumeMicros.store(duration, std::memory_order_relaxed);
+        }
+        if (stallThreshold.count() > 0 && duration >= static_cast<uint64_t>(stallThreshold.count()) * 1000) {
+            LOG_WARNING("单次协程恢复耗时 {:.1f}ms, 路由: {}", duration / 1e3, route);
+        }
+    }
+
+    // 由被恢复的协程调用，标记这次恢复服务的路由；route须在程序运行期间有效（Router持有的模式）
+    void noteRoute(std::string_view route) {
+        currentRoute = route;
+    }
+
+    // 启动看门狗：事件循环卡在同一轮中超过threshold时告警，每次卡顿只告警一次
+    void startWatchdog(std::chrono::milliseconds threshold) {
+        stallThreshold = threshold;
+        if (threshold.count() <= 0 || watchdogThread.joinable()) {
+            return;
+        }
+        stopping = false;
+        watchdogThread = std::thread([this] { runWatchdog(); });
+    }
+
+    void stopWatchdog() {
+        {
+            std::lock_guard<std::mutex> lock(watchdogMutex);
+            stopping = true;
+        }
+        stopCondition.notify_all();
+        if (watchdogThread.joinable()) {
+            watchdogThread.join();
+        }
+    }
+
+    uint64_t getWakeupCount() const {
+        return wakeups.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getIdleWakeupCount() const {
+        return idleWakeups.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getFullWakeupCount() const {
+        return fullWakeups.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getResumeCount() const {
+        return resumes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getStallCount() const {
+        return stalls.load(std::memory_order_relaxed);
+    }
+
+    size_t getBatchCapacity() const {
+        return batchCapacity.load(std::memory_order_relaxed);
+    }
+
+    // 最长的单次恢复（微秒）及其服务的路由
+    std::pair<uint64_t, std::string> getLongestResume() const {
+        std::lock_guard<std::mutex> lock(longestMutex);
+        return {longestResumeMicros.load(std::memory_order_relaxed), longestResumeRoute};
+    }
+
+    // 合并windowSeconds窗口内的调度延迟（微秒），windowSeconds为0时为启动以来
+    void collectLag(uint64_t windowSeconds, HistogramSnapshot& snapshot) const {
+        lag.collect(windowSeconds, epochSeconds(Clock::now()), snapshot);
+    }
+
+    // 每轮处理时间（微秒）
+    void collectIterations(uint64_t windowSeconds, HistogramSnapshot& snapshot) const {
+        iterations.collect(windowSeconds, epochSeconds(Clock::now()), snapshot);
+    }
+
+    // 每次非空唤醒返回的事件数
+    void collectBatchSizes(uint64_t windowSeconds, HistogramSnapshot& snapshot) const {
+        batchSizes.collect(windowSeconds, epochSeconds(Clock::now()), snapshot);
+    }
+
+    // 事件循环摘要，显示在/server-status中
+    std::string getStatusSummary() const {
+        if (!enabled) {
+            return "";
+        }
+        HistogramSnapshot sizes, iteration, delay;
+        collectBatchSizes(60, sizes);
+        collectIterations(60, iteration);
+        collectLag(60, delay);
+        auto [longest, route] = getLongestResume();
+        return fmt::format(
+            "事件循环 (最近1分钟, p50/p99/最大):\n"
+            "- 唤醒: {} 次, 空唤醒 {} 次, 批次填满 {} 次, 当前批次大小 {}\n"
+            "- 每次唤醒事件数: {}/{}/{}\n"
+            "- 每轮处理时间: {:.3f}/{:.3f}/{:.3f}ms\n"
+            "- 调度延迟: {:.3f}/{:.3f}/{:.3f}ms\n"
+            "- 最长单次恢复: {:.3f}ms ({}), 卡顿告警 {} 次\n",
+            getWakeupCount(), getIdleWakeupCount(), getFullWakeupCount(), getBatchCapacity(),
+            sizes.percentile(0.5), sizes.percentile(0.99), sizes.getMax(),
+            iteration.percentile(0.5) / 1e3, iteration.percentile(0.99) / 1e3, iteration.getMax() / 1e3,
+            delay.percentile(0.5) / 1e3, delay.percentile(0.99) / 1e3, delay.getMax() / 1e3,
+            longest / 1e3, route.empty() ? "-" : route, getStallCount());
+    }
+
+    ~EventLoopMonitor() {
+        stopWatchdog();
+    }
+
+private:
+    // 不属于任何请求的恢复（接受连接、文件监视、读取下一个请求等）
+    static constexpr std::string_view OTHER_ROUTE = "(other)";
+
+    EventLoopMonitor() = default;
+
+    // 禁止复制和移动
+    EventLoopMonitor(const EventLoopMonitor&) = delete;
+    EventLoopMonitor& operator=(const EventLoopMonitor&) = delete;
+    EventLoopMonitor(EventLoopMonitor&&) = delete;
+    EventLoopMonitor& operator=(EventLoopMonitor&&) = delete;
+
+    // 只有事件循环线程写入，relaxed的load/store即可
+    static void increment(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static uint64_t micros(Clock::time_point from, Clock::time_point to) {
+        return to > from ? std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() : 0;
+    }
+
+    static uint64_t epochSeconds(Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    }
+
+    // 以阈值的一半为周期检查当前一轮的开始时间
+    void runWatchdog() {
+        auto period = std::max(stallThreshold / 2, std::chrono::milliseconds(1));
+        Clock::rep reported = 0;
+        std::unique_lock<std::mutex> lock(watchdogMutex);
+        while (!stopCondition.wait_for(lock, period, [this] { return stopping; })) {
+            Clock::rep since = busySince.load(std::memory_order_relaxed);
+            if (since == 0 || since == reported) {
+                continue;
+            }
+            auto blocked = Clock::now() - Clock::time_point(Clock::duration(since));
+            if (blocked >= stallThreshold) {
+                reported = since;
+                increment(stalls);
+                LOG_WARNING("事件循环已阻塞 {}ms（阈值 {}ms）",
+                    std::chrono::duration_cast<std::chrono::milliseconds>(blocked).count(), stallThreshold.count());
+            }
+        }
+    }
+
+    WindowedHistogram batchSizes;
+    WindowedHistogram iterations;
+    WindowedHistogram lag;
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<uint64_t> idleWakeups{0};
+    std::atomic<uint64_t> fullWakeups{0};
+    std::atomic<uint64_t> resumes{0};
+    std::atomic<uint64_t> stalls{0};      // 只由看门狗线程写入
+    std::atomic<size_t> batchCapacity{0};
+    std::string_view currentRoute;        // 只在事件循环线程中读写
+
+    // 最长单次恢复，只在刷新最大值时加锁
+    mutable std::mutex longestMutex;
+    std::atomic<uint64_t> longestResumeMicros{0};
+    std::string longestResumeRoute;
+
+    // 当前一轮的开始时间（steady_clock计数），0表示事件循环在等待事件
+    std::atomic<Clock::rep> busySince{0};
+    std::chrono::milliseconds stallThreshold{0};
+    std::mutex watchdogMutex;
+    std::condition_variable stopCondition;
+    bool stopping = false;
+    std::thread watchdogThread;
+    bool enabled = false;
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 对数线性直方图（HDR风格）：每个2的幂区间再等分为SUB_BUCKETS个桶，相对误差不超过1/32
+// 单位由调用方决定（延迟统计使用微秒），桶数固定，占用内存固定，同结构的直方图可以直接相加合并
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_BITS = 32; // 超过2^32-1的值记入最后一个桶
+    static constexpr uint64_t MAX_VALUE = (uint64_t{1} << MAX_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (MAX_BITS - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    static size_t bucketIndex(uint64_t value) {
+        value = std::min(value, MAX_VALUE);
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        unsigned bits = std::bit_width(value) - 1; // 所在的2的幂区间
+        unsigned shift = bits - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // 桶内最小值
+    static uint64_t bucketLowerBound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << shift;
+    }
+
+    // 桶内最大值
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        return bucketLowerBound(index) + (uint64_t{1} << shift) - 1;
+    }
+};
+
+// 直方图的只读副本，用于合并多个线程或多个时间片后计算分位数
+class HistogramSnapshot {
+public:
+    HistogramSnapshot() : counts(LatencyHistogram::BUCKET_COUNT, 0) {}
+
+    void add(size_t bucket, uint64_t n) {
+        counts[bucket] += n;
+    }
+
+    void addSummary(uint64_t n, uint64_t total, uint64_t maximum) {
+        count += n;
+        sum += total;
+        max = std::max(max, maximum);
+    }
+
+    void merge(const HistogramSnapshot& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        addSummary(other.count, other.sum, other.max);
+    }
+
+    uint64_t getCount() const {
+        return count;
+    }
+
+    uint64_t getSum() const {
+        return sum;
+    }
+
+    uint64_t getMax() const {
+        return max;
+    }
+
+    double mean() const {
+        return count > 0 ? static_cast<double>(sum) / count : 0;
+    }
+
+    // 分位数（q取0到1），返回所在桶的上界，不超过记录到的最大值
+    uint64_t percentile(double q) const {
+        uint64_t total = 0;
+        for (uint64_t n : counts) {
+            total += n;
+        }
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(LatencyHistogram::bucketUpperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    // 小于等于value的记录数，用于输出累积分布的桶
+    uint64_t countAtOrBelow(uint64_t value) const {
+        uint64_t result = 0;
+        for (size_t i = 0; i < counts.size() && LatencyHistogram::bucketUpperBound(i) <= value; ++i) {
+            result += counts[i];
+        }
+        return result;
+    }
+
+private:
+    std::vector<uint64_t> counts;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+// 记录用的直方图：只有所属线程写入（relaxed的load/store，不用原子读-改-写），其他线程随时读取合并
+class AtomicHistogram {
+public:
+    void record(uint64_t value) {
+        bump(counts[LatencyHistogram::bucketIndex(value)]);
+        bump(count);
+        sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max.load(std::memory_order_relaxed)) {
+            max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // 只能由写入线程调用
+    void clear() {
+        for (auto& bucket : counts) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    void mergeInto(HistogramSnapshot& snapshot) const {
+        if (count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        for (size_t i = 0; i < counts.size(); ++i) {
+            uint32_t n = counts[i].load(std::memory_order_relaxed);
+            if (n != 0) {
+                snapshot.add(i, n);
+            }
+        }
+        snapshot.addSummary(count.load(std::memory_order_relaxed), sum.load(std::memory_order_relaxed),
+                            max.load(std::memory_order_relaxed));
+    }
+
+private:
+    static void bump(std::atomic<uint32_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint32_t>, LatencyHistogram::BUCKET_COUNT> counts{};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+};
+
+// 滑动窗口直方图：累计直方图加上按时间片轮转的直方图环，读取时合并最近若干个时间片
+// 时间片在写入时惰性清空，读取与清空并发时结果可能短暂偏小，统计用途可以接受
+class WindowedHistogram {
+public:
+    static constexpr uint64_t SLICE_SECONDS = 15;
+    static constexpr size_t SLICES = 20; // 最长窗口5分钟
+
+    // epochSeconds为单调时钟的秒数，调用方每次请求取一次时间后传入
+    void record(uint64_t value, uint64_t epochSeconds) {
+        total.record(value);
+        uint64_t sliceEpoch = epochSeconds / SLICE_SECONDS;
+        Slice& slice = slices[sliceEpoch % SLICES];
+        if (slice.epoch.load(std::memory_order_relaxed) != sliceEpoch) {
+            slice.histogram.clear();
+            slice.epoch.store(sliceEpoch, std::memory_order_release);
+        }
+        slice.histogram.record(value);
+    }
+
+    // 合并最近windowSeconds秒（按时间片取整，包含当前未结束的时间片）的记录；windowSeconds为0时合并全部
+    void collect(uint64_t windowSeconds, uint64_t epochSeconds, HistogramSnapshot& snapshot) const {
+        if (windowSeconds == 0) {
+            total.mergeInto(snapshot);
+            return;
+        }
+        uint64_t current = epochSeconds / SLICE_SECONDS;
+        uint64_t count = std::clamp<uint64_t>(windowSeconds / SLICE_SECONDS, 1, SLICES);
+        for (const auto& slice : slices) {
+            uint64_t epoch = slice.epoch.load(std::memory_order_acquire);
+            if (epoch != UNUSED && epoch <= current && current - epoch < count) {
+                slice.histogram.mergeInto(snapshot);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t UNUSED = ~uint64_t{0};
+
+    struct Slice {
+        std::atomic<uint64_t> epoch{UNUSED};
+        AtomicHistogram histogram;
+    };
+
+    AtomicHistogram total;
+    std::array<Slice, SLICES> slices;
+};
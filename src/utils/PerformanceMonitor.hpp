@@ -1,110 +1,191 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <string>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <mutex>
-#include <atomic>
-#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <fmt/format.h>
 #include "../core/Logger.hpp"
+#include "LatencyHistogram.hpp"
+#include "RequestTimeline.hpp"
 
+// 性能监控：每个线程写自己的计数器（单写者，relaxed原子操作，不加锁），读取时汇总所有线程
+// 请求的开始时间由调用方（连接）持有，不登记到全局表中
+// 处理时间按 路由 x 方法 x 状态类别 记入滑动窗口直方图，读取时合并各线程计算分位数
+// 连接提供时间线时，各阶段耗时也分别记入每个阶段的直方图
 class PerformanceMonitor {
 public:
     static PerformanceMonitor& getInstance() {
         static PerformanceMonitor instance;
         return instance;
     }
-    
+
     // 设置是否启用性能监控
     void setEnabled(bool enabled) {
         this->enabled = enabled;
     }
-    
+
     // 获取是否启用性能监控
     bool isEnabled() const {
         return enabled;
     }
 
-    // 开始一个请求的计时
-    void startRequest(const std::string& requestId, const std::string& method, const std::string& path) {
-        if (!enabled) return;
-        
-        std::lock_guard<std::mutex> lock(mutex);
-        auto now = std::chrono::high_resolution_clock::now();
-        requests[requestId] = {method, path, now, {}};
-        activeRequests++;
-        totalRequests++;
+    // 请求的计时信息，由调用方持有直到endRequest
+    // method和path是指向请求的视图，在endRequest之前必须保持有效
+    struct RequestInfo {
+        std::string_view method;
+        std::string_view path;
+        std::string_view route;  // 匹配到的路由模式（由Router持有），为空表示未匹配
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t id = 0;      // 请求ID，只在需要写日志时才格式化
+        bool active = false;
+    };
+
+    // 开始一个请求的计时，owner用于生成请求ID（通常是连接对象）
+    RequestInfo startRequest(std::string_view method, std::string_view path, const void* owner = nullptr) {
+        if (!enabled) return {};
+
+        ThreadCounters& counters = local();
+        increment(counters.requests);
+        auto now = std::chrono::steady_clock::now();
+        uint64_t id = reinterpret_cast<uintptr_t>(owner) ^ static_cast<uint64_t>(now.time_since_epoch().count());
+        return RequestInfo{method, path, {}, now, id, true};
     }
 
-    // 结束一个请求的计时并更新统计信息
-    void endRequest(const std::string& requestId, int statusCode) {
-        if (!enabled) return;
-        
-        std::lock_guard<std::mutex> lock(mutex);
-        auto now = std::chrono::high_resolution_clock::now();
-        
-        auto it = requests.find(requestId);
-        if (it != requests.end()) {
-            // 计算处理时间（毫秒）
-            double processingTime = std::chrono::duration<double, std::milli>(now - it->second.startTime).count();
-            
-            // 更新总体统计
-            totalProcessingTime += processingTime;
-            requestsProcessed++;
-            
-            // 更新对应状态码的统计
-            statusCodes[statusCode]++;
-            
-            // 更新最大和最小处理时间
-            maxProcessingTime = std::max(maxProcessingTime, processingTime);
-            minProcessingTime = (minProcessingTime == 0) ? processingTime : std::min(minProcessingTime, processingTime);
-            
-            // 计算移动平均响应时间
-            if (avgProcessingTime == 0) {
-                avgProcessingTime = processingTime;
-            } else {
-                avgProcessingTime = avgProcessingTime * 0.9 + processingTime * 0.1; // 移动平均
-            }
-            
-            // 记录处理时间
-            if (processingTime > slowThreshold) {
-                LOG_WARNING(fmt::format("慢请求: {} {} {} - {}ms (状态码: {})", 
-                    it->second.method, it->second.path, requestId, processingTime, statusCode));
-            } else {
-                LOG_DEBUG(fmt::format("请求完成: {} {} {} - {}ms (状态码: {})", 
-                    it->second.method, it->second.path, requestId, processingTime, statusCode));
+    // 结束一个请求的计时并更新统计信息，timeline不为空时同时记录各阶段耗时
+    void endRequest(const RequestInfo& info, int statusCode, const RequestTimeline* timeline = nullptr) {
+        if (!enabled || !info.active) return;
+
+        auto now = std::chrono::steady_clock::now();
+        uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now - info.startTime).count();
+
+        ThreadCounters& counters = local();
+        uint64_t epochSeconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+        counters.latency.record(nanos / 1000, epochSeconds);
+        if (Series* series = counters.findSeries(info.route.empty() ? UNMATCHED_ROUTE : info.route,
+                                                 methodLabel(info.method), statusClass(statusCode))) {
+            series->latency.record(nanos / 1000, epochSeconds);
+        }
+        if (timeline) {
+            std::array<uint64_t, RequestTimeline::PHASE_COUNT> phaseNanos;
+            std::array<bool, RequestTimeline::PHASE_COUNT> present;
+            timeline->durations(phaseNanos, present);
+            for (size_t phase = 0; phase < RequestTimeline::PHASE_COUNT; ++phase) {
+                if (present[phase]) {
+                    counters.phases[phase].record(phaseNanos[phase] / 1000, epochSeconds);
+                }
             }
-            
-            // 从活动请求中移除
-            requests.erase(it);
-            activeRequests--;
+        }
+
+        increment(counters.processed);
+        increment(counters.totalNanos, nanos);
+        increment(counters.statusClasses[statusClass(statusCode)]);
+        if (nanos > counters.maxNanos.load(std::memory_order_relaxed)) {
+            counters.maxNanos.store(nanos, std::memory_order_relaxed);
+        }
+        if (nanos < counters.minNanos.load(std::memory_order_relaxed)) {
+            counters.minNanos.store(nanos, std::memory_order_relaxed);
+        }
+
+        // 记录处理时间
+        double processingTime = nanos / 1e6;
+        if (processingTime > slowThreshold) {
+            LOG_WARNING("慢请求: {} {} {:x} - {}ms (状态码: {})",
+                info.method, info.path, info.id, processingTime, statusCode);
+        } else {
+            LOG_DEBUG("请求完成: {} {} {:x} - {}ms (状态码: {})",
+                info.method, info.path, info.id, processingTime, statusCode);
         }
     }
 
     // 记录连接建立
     void connectionEstablished() {
         if (!enabled) return;
-        
-        activeConnections++;
-        totalConnections++;
+
+        increment(local().connections);
     }
 
     // 记录连接关闭
     void connectionClosed() {
         if (!enabled) return;
-        
-        if (activeConnections > 0) {
-            activeConnections--;
+
+        increment(local().closedConnections);
+    }
+
+    // 记录从客户端读取和向客户端发送的字节数
+    void recordBytesIn(uint64_t bytes) {
+        if (!enabled) return;
+
+        increment(local().bytesIn, bytes);
+    }
+
+    void recordBytesOut(uint64_t bytes) {
+        if (!enabled) return;
+
+        increment(local().bytesOut, bytes);
+    }
+
+    // 所有线程计数器的汇总
+    struct Snapshot {
+        uint64_t requests = 0;
+        uint64_t processed = 0;
+        uint64_t connections = 0;
+        uint64_t closedConnections = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        uint64_t totalNanos = 0;
+        uint64_t minNanos = 0;
+        uint64_t maxNanos = 0;
+        std::array<uint64_t, 6> statusClasses{}; // 下标为状态码百位，0表示无效状态码
+
+        uint64_t activeRequests() const {
+            return requests > processed ? requests - processed : 0;
+        }
+
+        uint64_t activeConnections() const {
+            return connections > closedConnections ? connections - closedConnections : 0;
         }
+    };
+
+    // 汇总各线程的计数器，读取期间写入照常进行，结果是近似一致的快照
+    Snapshot snapshot() const {
+        Snapshot result;
+        uint64_t minNanos = std::numeric_limits<uint64_t>::max();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& counters : threads) {
+            result.requests += counters->requests.load(std::memory_order_relaxed);
+            result.processed += counters->processed.load(std::memory_order_relaxed);
+            result.connections += counters->connections.load(std::memory_order_relaxed);
+            result.closedConnections += counters->closedConnections.load(std::memory_order_relaxed);
+            result.bytesIn += counters->bytesIn.load(std::memory_order_relaxed);
+            result.bytesOut += counters->bytesOut.load(std::memory_order_relaxed);
+            result.totalNanos += counters->totalNanos.load(std::memory_order_relaxed);
+            result.maxNanos = std::max(result.maxNanos, counters->maxNanos.load(std::memory_order_relaxed));
+            minNanos = std::min(minNanos, counters->minNanos.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < result.statusClasses.size(); ++i) {
+                result.statusClasses[i] += counters->statusClasses[i].load(std::memory_order_relaxed);
+            }
+        }
+        result.minNanos = result.processed > 0 ? minNanos : 0;
+        return result;
     }
 
     // 获取性能统计摘要
     std::string getStatsSummary() const {
         if (!enabled) return "性能监控已禁用";
-        
-        std::lock_guard<std::mutex> lock(mutex);
-        
-        return fmt::format(
+
+        Snapshot stats = snapshot();
+        double average = stats.processed > 0 ? stats.totalNanos / 1e6 / stats.processed : 0;
+
+        std::string summary = fmt::format(
             "性能统计:\n"
             "- 总请求数: {}\n"
             "- 处理完成请求数: {}\n"
@@ -115,16 +196,152 @@ public:
             "- 最小处理时间: {:.2f}ms\n"
             "- 最大处理时间: {:.2f}ms\n"
             "- 慢请求阈值: {:.2f}ms\n",
-            totalRequests.load(),
-            requestsProcessed.load(),
-            activeRequests.load(),
-            activeConnections.load(),
-            totalConnections.load(),
-            avgProcessingTime,
-            minProcessingTime,
-            maxProcessingTime,
+            stats.requests,
+            stats.processed,
+            stats.activeRequests(),
+            stats.activeConnections(),
+            stats.connections,
+            average,
+            stats.minNanos / 1e6,
+            stats.maxNanos / 1e6,
             slowThreshold
         );
+        fmt::format_to(std::back_inserter(summary), "- 状态码分布: 1xx {} / 2xx {} / 3xx {} / 4xx {} / 5xx {}\n",
+            stats.statusClasses[1], stats.statusClasses[2], stats.statusClasses[3],
+            stats.statusClasses[4], stats.statusClasses[5]);
+        return summary + getLatencySummary() + getPhaseSummary();
+    }
+
+    // 统计窗口：最近1分钟、最近5分钟和启动以来（0）
+    static constexpr uint64_t LATENCY_WINDOWS[] = {60, 300, 0};
+
+    // 一组（路由, 方法, 状态类别）合并各线程后的延迟分布，单位为微秒
+    struct LatencySeries {
+        std::string_view route;
+        std::string_view method;
+        size_t statusClass;
+        HistogramSnapshot histogram;
+    };
+
+    // 合并各线程在windowSeconds窗口内的延迟分布：第一项为全部请求，其后按路由、方法、状态类别分组
+    std::vector<LatencySeries> collectLatency(uint64_t windowSeconds) const {
+        uint64_t epochSeconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::vector<LatencySeries> result;
+        result.push_back(LatencySeries{"*", "*", 0, {}});
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& counters : threads) {
+            counters->latency.collect(windowSeconds, epochSeconds, result[0].histogram);
+            size_t count = counters->seriesCount.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                const Series& series = *counters->series[i];
+                auto it = std::find_if(result.begin() + 1, result.end(), [&series](const LatencySeries& merged) {
+                    return merged.route == series.route && merged.method == series.method &&
+                           merged.statusClass == series.statusClass;
+                });
+                if (it == result.end()) {
+                    result.push_back(LatencySeries{series.route, series.method, series.statusClass, {}});
+                    it = result.end() - 1;
+                }
+                series.latency.collect(windowSeconds, epochSeconds, it->histogram);
+            }
+        }
+        // 去掉窗口内没有记录的分组，其余按请求数从多到少排列
+        result.erase(std::remove_if(result.begin() + 1, result.end(), [](const LatencySeries& series) {
+            return series.histogram.getCount() == 0;
+        }), result.end());
+        std::sort(result.begin() + 1, result.end(), [](const LatencySeries& a, const LatencySeries& b) {
+            return a.histogram.getCount() > b.histogram.getCount();
+        });
+        return result;
+    }
+
+    // 合并各线程在windowSeconds窗口内某一阶段的耗时分布（微秒）
+    void collectPhase(RequestTimeline::Phase phase, uint64_t windowSeconds, HistogramSnapshot& snapshot) const {
+        uint64_t epochSeconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& counters : threads) {
+            counters->phases[phase].collect(windowSeconds, epochSeconds, snapshot);
+        }
+    }
+
+    // 最近1分钟各阶段的耗时分位数，没有发生过的阶段不列出
+    std::string getPhaseSummary() const {
+        if (!enabled) return "";
+
+        std::string summary = "阶段耗时 (最近1分钟, p50/p90/p99/最大, ms):\n";
+        for (size_t phase = 0; phase < RequestTimeline::PHASE_COUNT; ++phase) {
+            HistogramSnapshot h;
+            collectPhase(static_cast<RequestTimeline::Phase>(phase), LATENCY_WINDOWS[0], h);
+            if (h.getCount() == 0) {
+                continue;
+            }
+            fmt::format_to(std::back_inserter(summary), "- {}: {} 次, {:.3f}/{:.3f}/{:.3f}/{:.3f}\n",
+                RequestTimeline::PHASE_LABELS[phase], h.getCount(), h.percentile(0.5) / 1e3,
+                h.percentile(0.9) / 1e3, h.percentile(0.99) / 1e3, h.getMax() / 1e3);
+        }
+        return summary;
+    }
+
+    // 延迟分位数摘要：各窗口的全部请求，以及最近1分钟内各分组
+    std::string getLatencySummary() const {
+        if (!enabled) return "";
+
+        std::string summary = "延迟分布 (p50/p90/p99/p99.9/最大, ms):\n";
+        auto appendLine = [&summary](std::string_view indent, std::string_view label, const HistogramSnapshot& h) {
+            fmt::format_to(std::back_inserter(summary), "{}- {}: {} 次, {:.3f}/{:.3f}/{:.3f}/{:.3f}/{:.3f}\n",
+                indent, label, h.getCount(), h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3,
+                h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3, h.getMax() / 1e3);
+        };
+        for (uint64_t window : LATENCY_WINDOWS) {
+            auto series = collectLatency(window);
+            appendLine("", windowLabel(window), series[0].histogram);
+            if (window == LATENCY_WINDOWS[0]) {
+                for (size_t i = 1; i < series.size(); ++i) {
+                    appendLine("  ", fmt::format("{} {} {}xx", series[i].method, series[i].route, series[i].statusClass),
+                               series[i].histogram);
+                }
+            }
+        }
+        return summary;
+    }
+
+    // 机器可读的延迟分布（JSON），单位为微秒
+    std::string getLatencyJson() const {
+        std::string json = "{\"unit\":\"us\",\"windows\":[";
+        for (uint64_t window : LATENCY_WINDOWS) {
+            if (window != LATENCY_WINDOWS[0]) {
+                json.push_back(',');
+            }
+            fmt::format_to(std::back_inserter(json), "{{\"seconds\":{},\"series\":[", window);
+            auto series = enabled ? collectLatency(window) : std::vector<LatencySeries>{};
+            for (size_t i = 0; i < series.size(); ++i) {
+                const HistogramSnapshot& h = series[i].histogram;
+                // 路由模式只含路径字符，不需要JSON转义
+                fmt::format_to(std::back_inserter(json),
+                    "{}{{\"route\":\"{}\",\"method\":\"{}\",\"status\":\"{}\",\"count\":{},\"mean\":{:.1f},"
+                    "\"p50\":{},\"p90\":{},\"p99\":{},\"p999\":{},\"max\":{}}}",
+                    i == 0 ? "" : ",", series[i].route, series[i].method,
+                    series[i].statusClass == 0 ? std::string("*") : fmt::format("{}xx", series[i].statusClass),
+                    h.getCount(), h.mean(), h.percentile(0.5), h.percentile(0.9), h.percentile(0.99),
+                    h.percentile(0.999), h.getMax());
+            }
+            json.append("]}");
+        }
+        // 各阶段耗时，窗口与上面第一个窗口相同
+        fmt::format_to(std::back_inserter(json), "],\"phases\":{{\"seconds\":{},\"series\":[", LATENCY_WINDOWS[0]);
+        for (size_t phase = 0; enabled && phase < RequestTimeline::PHASE_COUNT; ++phase) {
+            HistogramSnapshot h;
+            collectPhase(static_cast<RequestTimeline::Phase>(phase), LATENCY_WINDOWS[0], h);
+            fmt::format_to(std::back_inserter(json),
+                "{}{{\"phase\":\"{}\",\"count\":{},\"mean\":{:.1f},\"p50\":{},\"p90\":{},\"p99\":{},\"max\":{}}}",
+                phase == 0 ? "" : ",", RequestTimeline::PHASE_NAMES[phase], h.getCount(), h.mean(),
+                h.percentile(0.5), h.percentile(0.9), h.percentile(0.99), h.getMax());
+        }
+        json.append("]}}");
+        return json;
     }
 
     // 设置慢请求阈值
@@ -133,40 +350,101 @@ public:
     }
 
 private:
-    PerformanceMonitor() : 
-        totalRequests(0), 
-        requestsProcessed(0), 
-        activeRequests(0),
-        totalConnections(0),
-        activeConnections(0),
-        totalProcessingTime(0),
-        avgProcessingTime(0),
-        minProcessingTime(0),
-        maxProcessingTime(0),
-        slowThreshold(200) {} // 默认慢请求阈值为200ms
-    
-    struct RequestInfo {
-        std::string method;
-        std::string path;
-        std::chrono::high_resolution_clock::time_point startTime;
-        std::unordered_map<std::string, std::string> metadata;
+    static constexpr size_t MAX_SERIES = 64;
+    static constexpr std::string_view UNMATCHED_ROUTE = "(unmatched)";
+
+    // 一个（路由, 方法, 状态类别）分组；route指向Router持有的模式，method指向METHOD_LABELS中的常量
+    struct Series {
+        Series(std::string_view route, std::string_view method, size_t statusClass)
+            : route(route), method(method), statusClass(statusClass) {}
+
+        std::string_view route;
+        std::string_view method;
+        size_t statusClass;
+        WindowedHistogram latency;
+    };
+
+    // 每个线程一份，独占缓存行，避免线程之间的伪共享
+    struct alignas(64) ThreadCounters {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> closedConnections{0};
+        std::atomic<uint64_t> bytesIn{0};
+        std::atomic<uint64_t> bytesOut{0};
+        std::atomic<uint64_t> totalNanos{0};
+        std::atomic<uint64_t> minNanos{std::numeric_limits<uint64_t>::max()};
+        std::atomic<uint64_t> maxNanos{0};
+        std::array<std::atomic<uint64_t>, 6> statusClasses{};
+        WindowedHistogram latency;
+        std::array<WindowedHistogram, RequestTimeline::PHASE_COUNT> phases;  // 各阶段耗时
+
+        // 分组按需创建，只增不删；seriesCount以release发布，读取方按acquire读取后访问前seriesCount个
+        std::array<std::unique_ptr<Series>, MAX_SERIES> series;
+        std::atomic<size_t> seriesCount{0};
+
+        // 查找或创建分组，分组数达到上限时返回nullptr（只记入全部请求）
+        Series* findSeries(std::string_view route, std::string_view method, size_t status) {
+            size_t count = seriesCount.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < count; ++i) {
+                Series& candidate = *series[i];
+                if (candidate.statusClass == status && candidate.method.data() == method.data() &&
+                    candidate.route == route) {
+                    return &candidate;
+                }
+            }
+            if (count == MAX_SERIES) {
+                return nullptr;
+            }
+            series[count] = std::make_unique<Series>(route, method, status);
+            seriesCount.store(count + 1, std::memory_order_release);
+            return series[count].get();
+        }
     };
 
-    mutable std::mutex mutex;
-    std::unordered_map<std::string, RequestInfo> requests;
-    std::unordered_map<int, int> statusCodes;
-
-    std::atomic<size_t> totalRequests;
-    std::atomic<size_t> requestsProcessed;
-    std::atomic<size_t> activeRequests;
-    std::atomic<size_t> totalConnections;
-    std::atomic<size_t> activeConnections;
-    
-    double totalProcessingTime;
-    double avgProcessingTime;
-    double minProcessingTime;
-    double maxProcessingTime;
-    double slowThreshold;
+    PerformanceMonitor() = default;
+
+    // 只有所属线程写入，读-改-写不需要原子指令，relaxed的load/store即可
+    static void increment(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // 方法名映射到常量标签，避免分组引用请求缓冲区；不常见的方法归为OTHER
+    static std::string_view methodLabel(std::string_view method) {
+        static constexpr std::string_view METHOD_LABELS[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH"};
+        for (std::string_view label : METHOD_LABELS) {
+            if (label == method) {
+                return label;
+            }
+        }
+        return "OTHER";
+    }
+
+    static std::string windowLabel(uint64_t windowSeconds) {
+        return windowSeconds == 0 ? std::string("启动以来") : fmt::format("最近{}分钟", windowSeconds / 60);
+    }
+
+    static size_t statusClass(int statusCode) {
+        return (statusCode >= 100 && statusCode < 600) ? statusCode / 100 : 0;
+    }
+
+    // 当前线程的计数器，首次使用时登记；线程退出后计数器保留，汇总结果不会倒退
+    ThreadCounters& local() {
+        thread_local ThreadCounters* counters = nullptr;
+        if (counters == nullptr) {
+            auto created = std::make_unique<ThreadCounters>();
+            counters = created.get();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threads.push_back(std::move(created));
+        }
+        return *counters;
+    }
+
+    // 只在线程首次登记和读取汇总时加锁，请求路径上不加锁
+    mutable std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadCounters>> threads;
+
+    double slowThreshold{200}; // 默认慢请求阈值为200ms
     bool enabled = false;  // 是否启用性能监控
 
     // 禁止复制和移动
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include "../core/Logger.hpp"
+
+// 采样式CPU分析器：ITIMER_PROF定时器按进程消耗的CPU时间发出SIGPROF，
+// 信号处理函数沿帧指针回溯被打断线程的调用栈，写入预先分配的样本缓冲区
+// 结束后符号化并输出折叠栈（"线程;外层;...;内层 次数"），可直接交给flamegraph.pl等工具
+// 不在采样时不安装定时器，信号处理函数也只在第一次采样时安装，平时没有任何开销
+// 帧指针回溯依赖-fno-omit-frame-pointer编译；不保留帧指针的库函数会让调用栈在那里截断
+class Profiler {
+public:
+    static constexpr size_t MAX_FRAMES = 64;
+    static constexpr size_t MAX_SAMPLES = 1 << 16;
+
+    static Profiler& getInstance() {
+        static Profiler instance;
+        return instance;
+    }
+
+    // 以hz的频率开始采样，seconds用于估算缓冲区大小；已在采样或初始化失败时返回false
+    bool start(int hz, size_t seconds) {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        if (sampling) {
+            return false;
+        }
+
+        size_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+        capacity = std::min(static_cast<size_t>(hz) * seconds * cpus + 64, MAX_SAMPLES);
+        samples = std::make_unique<Sample[]>(capacity);
+        next.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+        loadStackRanges();
+
+        if (!handlerInstalled) {
+            struct sigaction action{};
+            action.sa_sigaction = onSignal;
+            action.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (sigaction(SIGPROF, &action, nullptr) == -1) {
+                LOG_ERROR("安装SIGPROF信号处理函数失败: {}", strerror(errno));
+                samples.reset();
+                return false;
+            }
+            handlerInstalled = true;
+        }
+
+        active.store(true);
+        struct itimerval timer{};
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = std::max(1000000 / hz, 1);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) == -1) {
+            LOG_ERROR("启动采样定时器失败: {}", strerror(errno));
+            active.store(false);
+            samples.reset();
+            return false;
+        }
+        sampling = true;
+        LOG_INFO("开始CPU采样, 频率 {}Hz, 样本缓冲区 {} 个", hz, capacity);
+        return true;
+    }
+
+    // 停止采样并返回折叠栈，未在采样时返回空字符串；可以重复调用
+    std::string stop() {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        if (!sampling) {
+            return {};
+        }
+        struct itimerval timer{};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        // 信号处理函数安装后保持安装（默认动作会终止进程），关闭开关后等待正在执行的处理函数退出
+        // 开关和计数都用顺序一致的原子操作：处理函数先计数再检查开关，这里先关开关再检查计数
+        active.store(false);
+        while (inFlight.load() != 0) {
+            std::this_thread::yield();
+        }
+        sampling = false;
+
+        size_t count = std::min(next.load(std::memory_order_relaxed), capacity);
+        std::string folded = fold(count);
+        LOG_INFO("CPU采样结束, 样本 {} 个, 缓冲区满丢弃 {} 个", count,
+            dropped.load(std::memory_order_relaxed));
+        samples.reset();
+        stackRanges.clear();
+        return folded;
+    }
+
+    bool isSampling() const {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        return sampling;
+    }
+
+private:
+    struct Sample {
+        std::atomic<uint32_t> depth{0};   // 写完后才以release发布，为0表示未完成
+        pid_t tid{0};
+        uintptr_t frames[MAX_FRAMES];     // frames[0]是被打断的指令，其余为返回地址
+    };
+
+    struct Range {
+        uintptr_t start;
+        uintptr_t end;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<size_t>::is_always_lock_free &&
+                  std::atomic<bool>::is_always_lock_free && std::atomic<int>::is_always_lock_free,
+                  "信号处理函数中只能使用无锁原子操作");
+
+    Profiler() = default;
+
+    // 禁止复制和移动
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    Profiler& operator=(Profiler&&) = delete;
+
+    // 记录开始采样时所有可读写的映射，回溯时要求帧指针始终落在栈指针所在的映射内，
+    // 避免沿着不保留帧指针的函数留下的无效值读到未映射的内存
+    void loadStackRanges() {
+        stackRanges.clear();
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        while (std::getline(maps, line)) {
+            unsigned long start, end;
+            char perms[5];
+            if (std::sscanf(line.c_str(), "%lx-%lx %4s", &start, &end, perms) == 3 && perms[0] == 'r' &&
+                perms[1] == 'w') {
+                stackRanges.push_back({start, end});
+            }
+        }
+        // /proc/self/maps按地址升序，信号处理函数中二分查找
+    }
+
+    // 以下在信号处理函数中执行，只能调用异步信号安全的函数、不能分配内存或加锁
+    static void onSignal(int, siginfo_t*, void* context) {
+        Profiler& profiler = getInstance();
+        int savedErrno = errno;
+        profiler.inFlight.fetch_add(1);
+        if (profiler.active.load()) {
+            profiler.record(static_cast<const ucontext_t*>(context));
+        }
+        profiler.inFlight.fetch_sub(1);
+        errno = savedErrno;
+    }
+
+    void record(const ucontext_t* context) {
+        size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Sample& sample = samples[index];
+        sample.tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+        uintptr_t pc, fp, sp;
+#if defined(__x86_64__)
+        pc = context->uc_mcontext.gregs[REG_RIP];
+        fp = context->uc_mcontext.gregs[REG_RBP];
+        sp = context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+        pc = context->uc_mcontext.pc;
+        fp = context->uc_mcontext.regs[29];
+        sp = context->uc_mcontext.sp;
+#else
+        (void)context;
+        pc = fp = sp = 0;
+#endif
+        uint32_t depth = 0;
+        sample.frames[depth++] = pc;
+
+        // 帧布局：[fp]为上一帧的帧指针，[fp + 8]为返回地址；帧指针必须对齐、严格递增且不离开当前栈
+        const Range* stack = findRange(sp);
+        while (stack != nullptr && depth < MAX_FRAMES && fp % sizeof(uintptr_t) == 0 && fp >= sp &&
+               fp >= stack->start && fp + 2 * sizeof(uintptr_t) <= stack->end) {
+            const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+            uintptr_t returnAddress = frame[1];
+            if (returnAddress == 0) {
+                break;
+            }
+            sample.frames[depth++] = returnAddress;
+            if (frame[0] <= fp) {
+                break;
+            }
+            sp = fp;
+            fp = frame[0];
+        }
+        sample.depth.store(depth, std::memory_order_release);
+    }
+
+    const Range* findRange(uintptr_t address) const {
+        auto it = std::upper_bound(stackRanges.begin(), stackRanges.end(), address,
+            [](uintptr_t value, const Range& range) { return value < range.end; });
+        return (it != stackRanges.end() && address >= it->start) ? &*it : nullptr;
+    }
+
+    // 以下在停止采样后执行
+
+    // 合并相同的调用栈，按出现次数降序输出
+    std::string fold(size_t count) {
+        std::unordered_map<uintptr_t, std::string> symbols;
+        std::unordered_map<pid_t, std::string> threads;
+        std::unordered_map<std::string, size_t> stacks;
+        std::string key;
+        for (size_t i = 0; i < count; ++i) {
+            const Sample& sample = samples[i];
+            uint32_t depth = sample.depth.load(std::memory_order_acquire);
+            if (depth == 0) {
+                continue;
+            }
+            auto thread = threads.find(sample.tid);
+            if (thread == threads.end()) {
+                thread = threads.emplace(sample.tid, threadName(sample.tid)).first;
+            }
+            key = thread->second;
+            for (uint32_t frame = depth; frame-- > 0;) {
+                // 返回地址指向调用指令之后，减一后落在调用指令上，避免调用在函数末尾时归到下一个函数
+                uintptr_t address = frame == 0 ? sample.frames[0] : sample.frames[frame] - 1;
+                auto symbol = symbols.find(address);
+                if (symbol == symbols.end()) {
+                    symbol = symbols.emplace(address, symbolize(address)).first;
+                }
+                key += ';';
+                key += symbol->second;
+            }
+            ++stacks[key];
+        }
+
+        std::vector<std::pair<std::string_view, size_t>> sorted(stacks.begin(), stacks.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::string result;
+        for (const auto& [stack, samplesInStack] : sorted) {
+            fmt::format_to(std::back_inserter(result), "{} {}\n", stack, samplesInStack);
+        }
+        return result;
+    }
+
+    // 线程名取自/proc，线程已退出时用线程号
+    static std::string threadName(pid_t tid) {
+        std::ifstream comm(fmt::format("/proc/self/task/{}/comm", tid));
+        std::string name;
+        if (!std::getline(comm, name) || name.empty()) {
+            name = fmt::format("thread-{}", tid);
+        }
+        return sanitize(std::move(name));
+    }
+
+    // 可执行文件需要以-rdynamic链接才能查到自身的符号；查不到符号时输出"模块+偏移"
+    static std::string symbolize(uintptr_t address) {
+        Dl_info info{};
+        if (dladdr(reinterpret_cast<void*>(address), &info) == 0) {
+            return fmt::format("0x{:x}", address);
+        }
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+            std::free(demangled);
+            return sanitize(std::move(name));
+        }
+        std::string_view module = info.dli_fname != nullptr ? info.dli_fname : "?";
+        module = module.substr(module.find_last_of('/') + 1);
+        return sanitize(fmt::format("{}+0x{:x}", module, address - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+    }
+
+    // 折叠栈以';'分隔帧、以最后一个空格分隔次数，帧名中的';'和换行需要替换
+    static std::string sanitize(std::string name) {
+        std::replace(name.begin(), name.end(), ';', ':');
+        std::replace(name.begin(), name.end(), '\n', ' ');
+        return name;
+    }
+
+    // 会话状态，只在start/stop中访问
+    mutable std::mutex sessionMutex;
+    bool sampling = false;
+    bool handlerInstalled = false;
+
+    // 采样期间由信号处理函数读写，缓冲区和栈映射在采样期间不变
+    std::unique_ptr<Sample[]> samples;
+    size_t capacity = 0;
+    std::vector<Range> stackRanges;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> active{false};
+    std::atomic<int> inFlight{0};
+};
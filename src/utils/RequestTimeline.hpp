@@ -0,0 +1,145 @@
+#pragma once
+
+#include <time.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+// 一个请求在各阶段边界上的时间戳和收发字节数，由连接持有，读取、处理、加载和发送的各环节分别打点
+// 只在启用性能监控或访问日志时由连接挂到请求和响应上；未挂上时各环节不打点
+struct RequestTimeline {
+    using Clock = std::chrono::steady_clock;
+
+    // 阶段：读取请求、加载排队、文件读取、缓存查找、处理函数（墙钟和CPU）、首字节、发送
+    enum Phase : size_t {
+        HeaderRead,   // 收到第一个字节到请求解析完成
+        QueueWait,    // 缓存未命中的加载在加载队列中等待的时间
+        FileIo,       // 加载线程读取文件的时间（未启用加载线程时为同步加载时间）
+        CacheLookup,  // 查找缓存的时间
+        Handler,      // 处理函数开始到结束（含等待加载和流式发送）
+        HandlerCpu,   // 处理函数实际占用的线程CPU时间，不含挂起期间
+        FirstByte,    // 请求解析完成到发出第一个字节
+        Write,        // 发出第一个字节到最后一个字节，慢客户端体现在这里
+        PHASE_COUNT
+    };
+
+    static constexpr std::array<std::string_view, PHASE_COUNT> PHASE_NAMES = {
+        "header_read", "queue_wait", "file_io", "cache_lookup", "handler", "handler_cpu", "first_byte", "write"};
+
+    static constexpr std::array<std::string_view, PHASE_COUNT> PHASE_LABELS = {
+        "读取请求", "加载排队", "文件读取", "缓存查找", "处理函数", "处理函数CPU", "首字节", "发送"};
+
+    Clock::time_point firstByte{};
+    Clock::time_point headersParsed{};
+    Clock::time_point handlerStart{};
+    Clock::time_point handlerEnd{};
+    Clock::time_point firstByteSent{};
+    Clock::time_point lastByteSent{};
+    uint64_t queueWaitNanos = 0;
+    uint64_t fileIoNanos = 0;
+    uint64_t cacheLookupNanos = 0;
+    uint64_t handlerCpuNanos = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t bytesSent = 0;
+    bool loaded = false;     // 是否发生了缓存未命中的加载
+    bool looked = false;     // 是否查找过缓存
+
+    void reset() {
+        *this = RequestTimeline{};
+    }
+
+    void markReceived(size_t bytes) {
+        if (firstByte == Clock::time_point{}) {
+            firstByte = Clock::now();
+        }
+        bytesReceived += bytes;
+    }
+
+    void markHeadersParsed() {
+        headersParsed = Clock::now();
+    }
+
+    void markSent(size_t bytes, bool complete) {
+        auto now = Clock::now();
+        bytesSent += bytes;
+        if (firstByteSent == Clock::time_point{}) {
+            firstByteSent = now;
+        }
+        if (complete) {
+            lastByteSent = now;
+        }
+    }
+
+    void beginHandler() {
+        handlerStart = Clock::now();
+        running = true;
+        cpuMark = threadCpuNanos();
+    }
+
+    // 未开始或已结束时不做任何事，处理函数正常返回和抛出异常时都可以调用
+    void endHandler() {
+        if (handlerStart == Clock::time_point{} || handlerEnd != Clock::time_point{}) {
+            return;
+        }
+        pauseHandler();
+        handlerEnd = Clock::now();
+    }
+
+    // 处理函数挂起前和恢复后调用，挂起期间线程在处理其他连接，不计入本请求的CPU时间
+    void pauseHandler() {
+        if (running) {
+            handlerCpuNanos += threadCpuNanos() - cpuMark;
+            running = false;
+        }
+    }
+
+    void resumeHandler() {
+        if (handlerStart != Clock::time_point{} && handlerEnd == Clock::time_point{} && !running) {
+            running = true;
+            cpuMark = threadCpuNanos();
+        }
+    }
+
+    // 计算各阶段耗时（纳秒），没有发生的阶段对应的present为false
+    void durations(std::array<uint64_t, PHASE_COUNT>& nanos, std::array<bool, PHASE_COUNT>& present) const {
+        present.fill(false);
+        auto between = [&](Phase phase, Clock::time_point from, Clock::time_point to) {
+            if (from != Clock::time_point{} && to != Clock::time_point{} && to >= from) {
+                nanos[phase] = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+                present[phase] = true;
+            }
+        };
+        between(HeaderRead, firstByte, headersParsed);
+        between(Handler, handlerStart, handlerEnd);
+        between(FirstByte, headersParsed, firstByteSent);
+        between(Write, firstByteSent, lastByteSent);
+        if (handlerEnd != Clock::time_point{}) {
+            nanos[HandlerCpu] = handlerCpuNanos;
+            present[HandlerCpu] = true;
+        }
+        if (looked) {
+            nanos[CacheLookup] = cacheLookupNanos;
+            present[CacheLookup] = true;
+        }
+        if (loaded) {
+            nanos[QueueWait] = queueWaitNanos;
+            nanos[FileIo] = fileIoNanos;
+            present[QueueWait] = present[FileIo] = true;
+        }
+    }
+
+    static uint64_t threadCpuNanos() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static uint64_t nanosBetween(Clock::time_point from, Clock::time_point to) {
+        return to > from ? std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count() : 0;
+    }
+
+private:
+    uint64_t cpuMark = 0;
+    bool running = false;
+};
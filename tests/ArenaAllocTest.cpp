@@ -0,0 +1,183 @@
+// 分配计数测试：缓存命中的keep-alive GET请求在 解析 → 路由 → 静态文件 → 响应序列化 的完整路径上
+// 不应使用全局堆（请求和响应状态都在连接的内存池中）
+// 替换全局operator new/delete计数，通过socketpair把请求交给真实的连接协程，由一个最小的事件循环驱动
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <charconv>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "src/core/Connection.hpp"
+#include "src/core/ConnectionManager.hpp"
+#include "src/core/Routes.hpp"
+#include "src/http/Router.hpp"
+
+static std::atomic<size_t> g_allocations{0};
+
+static void* countedAlloc(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+// 替换的operator new/delete直接使用malloc/free，GCC内联后会把它们误判为不匹配的分配和释放
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = countedAlignedAlloc(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void* p = countedAlignedAlloc(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+namespace {
+
+constexpr std::string_view REQUEST = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nUser-Agent: ArenaAllocTest\r\n\r\n";
+constexpr int WARMUP_REQUESTS = 3;
+constexpr int MEASURED_REQUESTS = 100;
+
+char g_response[64 * 1024];
+
+// 收到完整响应（头部加Content-Length指定的正文）时返回响应长度，否则返回0
+size_t completeResponseLength(std::string_view received) {
+    size_t headerEnd = received.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        return 0;
+    }
+    constexpr std::string_view LENGTH_HEADER = "Content-Length: ";
+    size_t lengthStart = received.find(LENGTH_HEADER);
+    if (lengthStart == std::string_view::npos || lengthStart > headerEnd) {
+        return 0;
+    }
+    lengthStart += LENGTH_HEADER.size();
+    size_t contentLength = 0;
+    std::from_chars(received.data() + lengthStart, received.data() + headerEnd, contentLength);
+    size_t total = headerEnd + 4 + contentLength;
+    return received.size() >= total ? total : 0;
+}
+
+// 发送一个请求并驱动事件循环直到收到完整响应，返回响应状态码，出错返回-1
+int roundTrip(int epollFd, int client) {
+    if (::send(client, REQUEST.data(), REQUEST.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(REQUEST.size())) {
+        return -1;
+    }
+    size_t received = 0;
+    epoll_event events[8];
+    for (int idle = 0; idle < 100;) {
+        int nfds = epoll_wait(epollFd, events, 8, 10);
+        for (int i = 0; i < nfds; ++i) {
+            std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+        }
+        ssize_t n = ::recv(client, g_response + received, sizeof(g_response) - received, MSG_DONTWAIT);
+        if (n > 0) {
+            received += n;
+            if (completeResponseLength(std::string_view(g_response, received)) == received) {
+                int status = 0;
+                std::from_chars(g_response + 9, g_response + 12, status);  // "HTTP/1.1 200"
+                return status;
+            }
+        } else if (nfds <= 0) {
+            ++idle;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+int main() {
+    char rootTemplate[] = "/tmp/arena-alloc-test-XXXXXX";
+    const char* root = mkdtemp(rootTemplate);
+    if (root == nullptr) {
+        std::perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+    std::string indexPath = std::string(root) + "/index.html";
+    {
+        std::ofstream index(indexPath);
+        index << "<html><body>" << std::string(2048, 'x') << "</body></html>\n";
+    }
+
+    if (!FileService::getInstance().init(root)) {
+        std::fprintf(stderr, "文件服务初始化失败: %s\n", root);
+        return EXIT_FAILURE;
+    }
+    Routes::registerAll(Router::getInstance());
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == -1) {
+        std::perror("socketpair");
+        return EXIT_FAILURE;
+    }
+    int server = sockets[0];
+    int client = sockets[1];
+    fcntl(server, F_SETFL, fcntl(server, F_GETFL) | O_NONBLOCK);
+    int epollFd = epoll_create1(0);
+
+    auto connection = std::make_shared<Connection>(server);
+    ConnectionManager::getInstance().addConnection(connection);
+    connection->startHandleConnection(epollFd);
+
+    // 预热：第一次请求加载文件并填充缓存，各单例和连接的内存池在这里完成初始化
+    for (int i = 0; i < WARMUP_REQUESTS; ++i) {
+        if (roundTrip(epollFd, client) != 200) {
+            std::fprintf(stderr, "预热请求失败\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t before = g_allocations.load();
+    for (int i = 0; i < MEASURED_REQUESTS; ++i) {
+        if (roundTrip(epollFd, client) != 200) {
+            std::fprintf(stderr, "第 %d 个请求失败\n", i + 1);
+            return EXIT_FAILURE;
+        }
+    }
+    size_t allocations = g_allocations.load() - before;
+
+    ::close(client);
+    unlink(indexPath.c_str());
+    rmdir(root);
+
+    if (allocations != 0) {
+        std::fprintf(stderr, "失败: %d 个缓存命中的keep-alive GET请求共分配堆内存 %zu 次\n", MEASURED_REQUESTS, allocations);
+        return EXIT_FAILURE;
+    }
+    std::printf("通过: %d 个缓存命中的keep-alive GET请求没有分配堆内存\n", MEASURED_REQUESTS);
+    return EXIT_SUCCESS;
+}
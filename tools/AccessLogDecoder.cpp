@@ -0,0 +1,237 @@
+// 访问日志解码工具：把服务器写出的二进制访问日志段转换为文本、CSV或JSON（每行一个对象）
+// 用法: AccessLogDecoder [--format text|csv|json] <段文件或目录>...
+// 传入目录时按序号顺序解码目录下所有access-<序号>.bin
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+#include "src/utils/AccessLog.hpp"
+
+namespace fs = std::filesystem;
+
+enum class OutputFormat {
+    Text,
+    Csv,
+    Json
+};
+
+// Unix纳秒时间转为UTC的ISO 8601格式，精确到微秒
+static std::string formatTimestamp(uint64_t nanos) {
+    time_t seconds = static_cast<time_t>(nanos / 1000000000);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char text[32];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &tm);
+    return fmt::format("{}.{:06}Z", std::string_view(text, length), nanos % 1000000000 / 1000);
+}
+
+static std::string formatAddress(const AccessLog::Record& record) {
+    char text[INET6_ADDRSTRLEN] = "-";
+    if (record.family == 4) {
+        inet_ntop(AF_INET, record.addr, text, sizeof(text));
+    } else if (record.family == 6) {
+        inet_ntop(AF_INET6, record.addr, text, sizeof(text));
+    }
+    return text;
+}
+
+static std::string_view methodName(uint8_t method) {
+    return method < std::size(AccessLog::METHOD_NAMES) ? AccessLog::METHOD_NAMES[method] : "OTHER";
+}
+
+static std::string escapeCsv(std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        return std::string(value);
+    }
+    std::string result = "\"";
+    for (char c : value) {
+        if (c == '"') {
+            result.push_back('"');
+        }
+        result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+static std::string escapeJson(std::string_view value) {
+    std::string result;
+    for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+            result.push_back(c);
+        } else if (c < 0x20) {
+            fmt::format_to(std::back_inserter(result), "\\u{:04x}", c);
+        } else {
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+static void printRecord(std::string& out, OutputFormat format, const AccessLog::Record& record, std::string_view path) {
+    std::string address = formatAddress(record);
+    std::string timestamp = formatTimestamp(record.timestamp);
+    bool keepAlive = record.flags & AccessLog::FLAG_KEEP_ALIVE;
+    switch (format) {
+        case OutputFormat::Text:
+            fmt::format_to(std::back_inserter(out),
+                "{} {}:{} \"{} {}\" {} {}B {}B {:.3f}ms (读取 {:.3f} 处理 {:.3f} 发送 {:.3f}){}\n",
+                timestamp, address, record.port, methodName(record.method), path, record.status,
+                record.bytesSent, record.bytesReceived, record.totalMicros / 1e3, record.headerReadMicros / 1e3,
+                record.handlerMicros / 1e3, record.writeMicros / 1e3, keepAlive ? " keep-alive" : "");
+            break;
+        case OutputFormat::Csv:
+            fmt::format_to(std::back_inserter(out), "{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                timestamp, address, record.port, methodName(record.method), escapeCsv(path), record.status,
+                record.bytesSent, record.bytesReceived, record.totalMicros, record.headerReadMicros,
+                record.handlerMicros, record.writeMicros, keepAlive ? 1 : 0);
+            break;
+        case OutputFormat::Json:
+            fmt::format_to(std::back_inserter(out),
+                "{{\"time\":\"{}\",\"client\":\"{}\",\"port\":{},\"method\":\"{}\",\"path\":\"{}\",\"status\":{},"
+                "\"bytes_sent\":{},\"bytes_received\":{},\"total_us\":{},\"header_read_us\":{},\"handler_us\":{},"
+                "\"write_us\":{},\"keep_alive\":{}}}\n",
+                timestamp, address, record.port, methodName(record.method), escapeJson(path), record.status,
+                record.bytesSent, record.bytesReceived, record.totalMicros, record.headerReadMicros,
+                record.handlerMicros, record.writeMicros, keepAlive ? "true" : "false");
+            break;
+    }
+}
+
+// 解码一个段，返回解码的请求数，格式错误时返回-1
+static long decodeSegment(const std::string& path, OutputFormat format) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        fmt::print(stderr, "错误: 无法打开 {}\n", path);
+        return -1;
+    }
+    std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    AccessLog::Header header{};
+    if (data.size() < sizeof(header)) {
+        fmt::print(stderr, "错误: {} 不是访问日志段\n", path);
+        return -1;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, AccessLog::MAGIC, sizeof(AccessLog::MAGIC)) != 0 ||
+        header.version != AccessLog::VERSION || header.slotSize != AccessLog::SLOT_SIZE) {
+        fmt::print(stderr, "错误: {} 不是访问日志段或版本不兼容\n", path);
+        return -1;
+    }
+
+    std::vector<std::string> paths;   // 下标为段内路径编号
+    std::string out;
+    long count = 0;
+    size_t offset = sizeof(header);
+    while (offset + AccessLog::SLOT_SIZE <= data.size()) {
+        uint8_t type = static_cast<uint8_t>(data[offset]);
+        if (type == AccessLog::SLOT_REQUEST) {
+            AccessLog::Record record;
+            std::memcpy(&record, data.data() + offset, sizeof(record));
+            std::string_view requestPath = record.pathId < paths.size() ? std::string_view(paths[record.pathId])
+                                                                        : std::string_view("-");
+            printRecord(out, format, record, requestPath);
+            ++count;
+            offset += AccessLog::SLOT_SIZE;
+        } else if (type == AccessLog::SLOT_PATH) {
+            AccessLog::PathRecord record;
+            std::memcpy(&record, data.data() + offset, sizeof(record));
+            size_t textOffset = offset + offsetof(AccessLog::PathRecord, text);
+            if (textOffset + record.length > data.size()) {
+                break;   // 写了一半的段
+            }
+            if (paths.size() <= record.pathId) {
+                paths.resize(record.pathId + 1);
+            }
+            paths[record.pathId].assign(data, textOffset, record.length);
+            offset += AccessLog::pathSlots(record.length) * AccessLog::SLOT_SIZE;
+        } else {
+            break;   // 段结束
+        }
+        if (out.size() >= 64 * 1024) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return count;
+}
+
+// 展开参数：文件原样保留，目录按序号展开为其中的段
+static std::vector<std::string> collectSegments(const std::vector<std::string>& arguments) {
+    std::vector<std::string> segments;
+    for (const auto& argument : arguments) {
+        if (!fs::is_directory(argument)) {
+            segments.push_back(argument);
+            continue;
+        }
+        std::vector<std::pair<uint64_t, std::string>> found;
+        for (const auto& entry : fs::directory_iterator(argument)) {
+            uint64_t sequence;
+            if (AccessLog::parseSegmentName(entry.path().filename().string(), sequence)) {
+                found.emplace_back(sequence, entry.path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        for (auto& [sequence, path] : found) {
+            segments.push_back(std::move(path));
+        }
+    }
+    return segments;
+}
+
+int main(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::Text;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--format" && i + 1 < argc) {
+            std::string_view value = argv[++i];
+            if (value == "text") {
+                format = OutputFormat::Text;
+            } else if (value == "csv") {
+                format = OutputFormat::Csv;
+            } else if (value == "json") {
+                format = OutputFormat::Json;
+            } else {
+                fmt::print(stderr, "错误: 未知的输出格式: {}\n", value);
+                return EXIT_FAILURE;
+            }
+        } else {
+            arguments.emplace_back(argument);
+        }
+    }
+    if (arguments.empty()) {
+        fmt::print("用法: {} [--format text|csv|json] <段文件或目录>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> segments;
+    try {
+        segments = collectSegments(arguments);
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "错误: 无法遍历目录: {}\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    if (format == OutputFormat::Csv) {
+        fmt::print("time,client,port,method,path,status,bytes_sent,bytes_received,total_us,header_read_us,"
+                   "handler_us,write_us,keep_alive\n");
+    }
+    bool failed = false;
+    for (const auto& segment : segments) {
+        if (decodeSegment(segment, format) < 0) {
+            failed = true;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
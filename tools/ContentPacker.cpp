@@ -0,0 +1,225 @@
+// 内容包打包工具：把静态文件目录打包成服务器可直接mmap的单个文件
+// 用法: ContentPacker <源目录> <输出文件> [--no-gzip]
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include "src/http/ContentPack.hpp"
+#include "src/http/FileService.hpp"
+#include "src/http/ResponseCache.hpp"
+
+namespace fs = std::filesystem;
+
+struct SourceFile {
+    std::string relativePath;
+    std::string fullPath;
+    uintmax_t size;
+    std::time_t mtime;
+};
+
+#ifdef HAS_ZLIB
+// 只压缩文本类内容，图片、视频、字体等已压缩格式不处理
+static bool isCompressible(const std::string& mimeType) {
+    return mimeType.rfind("text/", 0) == 0 ||
+           mimeType == "application/javascript" ||
+           mimeType == "application/json" ||
+           mimeType == "application/xml" ||
+           mimeType == "image/svg+xml";
+}
+
+// gzip压缩，失败时返回空字符串
+static std::string gzipCompress(const std::string& input) {
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+    std::string output;
+    output.resize(deflateBound(&stream, input.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = input.size();
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = output.size();
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END ? output : "";
+}
+#endif
+
+// 收集目录下的所有普通文件，按相对路径排序（与服务器端的二分查找顺序一致）
+static std::vector<SourceFile> collectFiles(const std::string& sourceDir) {
+    std::vector<SourceFile> files;
+    for (const auto& entry : fs::recursive_directory_iterator(sourceDir)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        struct stat st;
+        if (::stat(entry.path().c_str(), &st) != 0) {
+            continue;
+        }
+        files.push_back({fs::relative(entry.path(), sourceDir).generic_string(),
+                         entry.path().string(), static_cast<uintmax_t>(st.st_size), st.st_mtime});
+    }
+    std::sort(files.begin(), files.end(),
+        [](const SourceFile& a, const SourceFile& b) { return a.relativePath < b.relativePath; });
+    return files;
+}
+
+class PackWriter {
+public:
+    explicit PackWriter(const std::string& outputPath) : out(outputPath, std::ios::binary | std::ios::trunc) {}
+
+    bool isOpen() const {
+        return out.is_open();
+    }
+
+    uint64_t append(std::string_view data) {
+        uint64_t offset = position;
+        out.write(data.data(), data.size());
+        position += data.size();
+        return offset;
+    }
+
+    void writeAt(uint64_t offset, const void* data, size_t size) {
+        out.seekp(offset);
+        out.write(static_cast<const char*>(data), size);
+        out.seekp(position);
+    }
+
+    uint64_t size() const {
+        return position;
+    }
+
+    bool close() {
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    std::ofstream out;
+    uint64_t position{0};
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fmt::print("用法: {} <源目录> <输出文件> [--no-gzip]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string sourceDir = argv[1];
+    std::string outputPath = argv[2];
+    bool enableGzip = !(argc > 3 && std::string(argv[3]) == "--no-gzip");
+#ifndef HAS_ZLIB
+    enableGzip = false;
+#endif
+
+    if (!fs::is_directory(sourceDir)) {
+        fmt::print("错误: 源目录不存在: {}\n", sourceDir);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SourceFile> files;
+    try {
+        files = collectFiles(sourceDir);
+    } catch (const std::exception& e) {
+        fmt::print("错误: 无法遍历源目录: {}\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    // 先写到临时文件再重命名，服务器不会映射到写了一半的内容包
+    std::string tempPath = outputPath + ".tmp";
+    PackWriter writer(tempPath);
+    if (!writer.isOpen()) {
+        fmt::print("错误: 无法创建输出文件: {}\n", tempPath);
+        return EXIT_FAILURE;
+    }
+
+    // 头部和条目表先占位，数据写完后回填
+    ContentPack::Header header{};
+    std::copy(std::begin(ContentPack::MAGIC), std::end(ContentPack::MAGIC), header.magic);
+    header.version = ContentPack::VERSION;
+    header.entryCount = files.size();
+    header.entriesOffset = sizeof(ContentPack::Header);
+    std::vector<ContentPack::Entry> entries(files.size());
+    writer.append(std::string(sizeof(header) + entries.size() * sizeof(ContentPack::Entry), '\0'));
+
+    auto& fileService = FileService::getInstance();
+    uintmax_t originalBytes = 0;
+    size_t compressedCount = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const SourceFile& file = files[i];
+        ContentPack::Entry& entry = entries[i];
+
+        std::ifstream in(file.fullPath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!in && !in.eof()) {
+            fmt::print("错误: 无法读取文件: {}\n", file.fullPath);
+            return EXIT_FAILURE;
+        }
+        originalBytes += content.size();
+
+        std::string mimeType = fileService.getMimeType(file.fullPath);
+        std::string compressed;
+#ifdef HAS_ZLIB
+        if (enableGzip && isCompressible(mimeType)) {
+            compressed = gzipCompress(content);
+            // 压缩收益太小时不保留压缩版本
+            if (compressed.empty() || compressed.size() > content.size() * 9 / 10) {
+                compressed.clear();
+            }
+        }
+#endif
+        std::string vary = compressed.empty() ? "" : "Vary: Accept-Encoding\r\n";
+
+        entry.pathOffset = writer.append(file.relativePath);
+        entry.pathLength = file.relativePath.size();
+
+        std::string identityHeader = ResponseCache::buildHeaderBlock(200, mimeType, content.size(),
+            ResponseCache::buildValidators(content.size(), file.mtime) + vary);
+        entry.identity.headerLength = identityHeader.size();
+        entry.identity.headerOffset = writer.append(identityHeader);
+        entry.identity.bodyLength = content.size();
+        entry.identity.bodyOffset = writer.append(content);
+
+        if (!compressed.empty()) {
+            std::string gzipHeader = ResponseCache::buildHeaderBlock(200, mimeType, compressed.size(),
+                ResponseCache::buildValidators(content.size(), file.mtime, "-gz") +
+                "Content-Encoding: gzip\r\n" + vary);
+            entry.flags |= ContentPack::FLAG_GZIP;
+            entry.gzip.headerLength = gzipHeader.size();
+            entry.gzip.headerOffset = writer.append(gzipHeader);
+            entry.gzip.bodyLength = compressed.size();
+            entry.gzip.bodyOffset = writer.append(compressed);
+            compressedCount++;
+        }
+    }
+
+    header.fileSize = writer.size();
+    writer.writeAt(0, &header, sizeof(header));
+    if (!entries.empty()) {
+        writer.writeAt(header.entriesOffset, entries.data(), entries.size() * sizeof(ContentPack::Entry));
+    }
+    uint64_t packSize = writer.size();
+    if (!writer.close()) {
+        fmt::print("错误: 写入输出文件失败: {}\n", tempPath);
+        return EXIT_FAILURE;
+    }
+
+    if (std::rename(tempPath.c_str(), outputPath.c_str()) != 0) {
+        fmt::print("错误: 无法重命名输出文件: {}\n", outputPath);
+        return EXIT_FAILURE;
+    }
+
+    fmt::print("已打包 {} 个文件 ({} 个含gzip版本), 原始大小 {:.1f}MB, 内容包大小 {:.1f}MB: {}\n",
+               files.size(), compressedCount, originalBytes / (1024.0 * 1024),
+               packSize / (1024.0 * 1024), outputPath);
+    return EXIT_SUCCESS;
+}